@@ -2,11 +2,11 @@
 #include "additional_unit.h"
 
 void additional_unit::do_something() {
-    _log.info("I did something");
+    _log->info("I did something");
 }
 
-additional_unit::additional_unit() :  _log( "AdditionalUnit"){
-    _log.info("Additional unit created");
+additional_unit::additional_unit() :  _log(seq_logger::seq::get("AdditionalUnit")){
+    _log->info("Additional unit created");
 }
 
 additional_unit::~additional_unit() {
@@ -6,7 +6,7 @@
 
 
 class additional_unit {
-    seq_logger::seq _log;
+    std::shared_ptr<seq_logger::seq> _log;
 public:
     additional_unit();
     void do_something();
@@ -0,0 +1,465 @@
+// Microbenchmarks for the hot parts of seq.hpp.
+// Every benchmark reports latency percentiles (per call, measured over small batches of calls so that clock overhead
+// does not dominate) and the number of heap allocations per call.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HTTPRequest.hpp"
+#include "seq.hpp"
+#include "seq_binary.hpp"
+#include "seq_file.hpp"
+
+namespace {
+    thread_local uint64_t allocations = 0;
+}
+
+// Counting replacements of all allocation functions, so that every pointer passed to free() comes from malloc() or
+// aligned_alloc()
+namespace {
+    void *counted_allocate(std::size_t size_, std::size_t alignment_) noexcept {
+        ++allocations;
+        if (size_ == 0) size_ = 1;
+        if (alignment_ <= alignof(std::max_align_t)) return std::malloc(size_);
+        // aligned_alloc needs a multiple of the alignment
+        return std::aligned_alloc(alignment_, (size_ + alignment_ - 1) / alignment_ * alignment_);
+    }
+
+    void *counted_allocate_or_throw(std::size_t size_, std::size_t alignment_) {
+        if (auto *ptr = counted_allocate(size_, alignment_)) return ptr;
+        throw std::bad_alloc();
+    }
+}
+
+void *operator new(std::size_t size_) {
+    return counted_allocate_or_throw(size_, 0);
+}
+
+void *operator new[](std::size_t size_) {
+    return counted_allocate_or_throw(size_, 0);
+}
+
+void *operator new(std::size_t size_, std::align_val_t alignment_) {
+    return counted_allocate_or_throw(size_, static_cast<std::size_t>(alignment_));
+}
+
+void *operator new[](std::size_t size_, std::align_val_t alignment_) {
+    return counted_allocate_or_throw(size_, static_cast<std::size_t>(alignment_));
+}
+
+void *operator new(std::size_t size_, const std::nothrow_t &) noexcept {
+    return counted_allocate(size_, 0);
+}
+
+void *operator new[](std::size_t size_, const std::nothrow_t &) noexcept {
+    return counted_allocate(size_, 0);
+}
+
+void *operator new(std::size_t size_, std::align_val_t alignment_, const std::nothrow_t &) noexcept {
+    return counted_allocate(size_, static_cast<std::size_t>(alignment_));
+}
+
+void *operator new[](std::size_t size_, std::align_val_t alignment_, const std::nothrow_t &) noexcept {
+    return counted_allocate(size_, static_cast<std::size_t>(alignment_));
+}
+
+void operator delete(void *ptr_) noexcept {
+    std::free(ptr_);
+}
+
+void operator delete[](void *ptr_) noexcept {
+    std::free(ptr_);
+}
+
+void operator delete(void *ptr_, std::size_t) noexcept {
+    std::free(ptr_);
+}
+
+void operator delete[](void *ptr_, std::size_t) noexcept {
+    std::free(ptr_);
+}
+
+void operator delete(void *ptr_, std::align_val_t) noexcept {
+    std::free(ptr_);
+}
+
+void operator delete[](void *ptr_, std::align_val_t) noexcept {
+    std::free(ptr_);
+}
+
+void operator delete(void *ptr_, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr_);
+}
+
+void operator delete[](void *ptr_, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr_);
+}
+
+void operator delete(void *ptr_, const std::nothrow_t &) noexcept {
+    std::free(ptr_);
+}
+
+void operator delete[](void *ptr_, const std::nothrow_t &) noexcept {
+    std::free(ptr_);
+}
+
+void operator delete(void *ptr_, std::align_val_t, const std::nothrow_t &) noexcept {
+    std::free(ptr_);
+}
+
+void operator delete[](void *ptr_, std::align_val_t, const std::nothrow_t &) noexcept {
+    std::free(ptr_);
+}
+
+namespace seq_logger {
+    struct benchmark_access {
+        static void init_time(seq_log_entry &entry_) {
+            entry_.init_time();
+        }
+
+        static seq_context make_context(const seq &logger_, logging_level level_, seq_properties_vector_t properties_) {
+            return logger_.make_context(level_, std::move(properties_));
+        }
+
+        static void enqueue(const seq &logger_, std::string message_, seq_context &&context_) {
+            logger_.enqueue(std::move(message_), std::move(context_));
+        }
+
+        static size_t drain(const seq &logger_) {
+            std::lock_guard<std::mutex> guard(logger_._logs_mutex);
+            size_t count = 0;
+            for (auto *queue: {&logger_._seq_dispatch_queue, &logger_._seq_priority_queue}) {
+                count += queue->size();
+                for (auto *entry: *queue) delete entry;
+                queue->clear();
+            }
+            return count;
+        }
+    };
+}
+
+namespace {
+    using namespace seq_logger;
+    using clock_type = std::chrono::steady_clock;
+
+    struct result {
+        std::vector<double> samples_ns;
+        uint64_t calls{0};
+        uint64_t allocations{0};
+    };
+
+    constexpr size_t batch_size = 16;
+
+    double percentile(const std::vector<double> &sorted_, double p_) {
+        if (sorted_.empty()) return 0;
+        auto index = static_cast<size_t>(p_ * static_cast<double>(sorted_.size() - 1));
+        return sorted_[index];
+    }
+
+    void report(const std::string &name_, result &result_) {
+        std::sort(result_.samples_ns.begin(), result_.samples_ns.end());
+        std::printf("%-48s %10.1f %10.1f %10.1f %10.2f\n", name_.c_str(),
+                    percentile(result_.samples_ns, 0.5),
+                    percentile(result_.samples_ns, 0.99),
+                    percentile(result_.samples_ns, 0.999),
+                    result_.calls == 0 ? 0.0 : static_cast<double>(result_.allocations) / static_cast<double>(result_.calls));
+    }
+
+    /// Runs body_ samples_ * batch_size times on the calling thread, one latency sample per batch
+    result measure(size_t samples_, const std::function<void()> &body_) {
+        result r;
+        r.samples_ns.reserve(samples_);
+        for (size_t i = 0; i < samples_ / 10; ++i) body_(); // warm up
+        for (size_t i = 0; i < samples_; ++i) {
+            auto allocations_before = allocations;
+            auto start = clock_type::now();
+            for (size_t j = 0; j < batch_size; ++j) body_();
+            auto elapsed = clock_type::now() - start;
+            r.allocations += allocations - allocations_before;
+            r.calls += batch_size;
+            r.samples_ns.push_back(
+                    static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / batch_size);
+        }
+        return r;
+    }
+
+    void run(const std::string &name_, size_t samples_, const std::function<void()> &body_) {
+        auto r = measure(samples_, body_);
+        report(name_, r);
+    }
+
+    seq_properties_vector_t make_properties(size_t count_) {
+        seq_properties_vector_t properties;
+        for (size_t i = 0; i < count_; ++i) {
+            properties.emplace_back("Property" + std::to_string(i), "Value number " + std::to_string(i));
+        }
+        return properties;
+    }
+
+    void bench_escape_json(size_t samples_) {
+        const std::string plain = "User 12345 logged in from the main office";
+        const std::string escaped = "Path \"C:\\temp\"\n\tline two\r\n\x01";
+        run("escape_json/plain", samples_, [&] { auto s = helpers::escape_json(plain); });
+        run("escape_json/with escapes", samples_, [&] { auto s = helpers::escape_json(escaped); });
+    }
+
+    void bench_stringified_value(size_t samples_) {
+        const std::string str = "some string value";
+        run("stringified_value/const char*", samples_, [&] { stringified_value v("some string value"); });
+        run("stringified_value/std::string", samples_, [&] { stringified_value v(str); });
+        run("stringified_value/int32_t", samples_, [&] { stringified_value v(int32_t{123456}); });
+        run("stringified_value/uint64_t", samples_, [&] { stringified_value v(uint64_t{1234567890123}); });
+        run("stringified_value/double", samples_, [&] { stringified_value v = 3.14159; });
+        run("stringified_value/std::thread::id", samples_, [&] { stringified_value v = std::this_thread::get_id(); });
+    }
+
+    void bench_clock(size_t samples_) {
+        run("seq_clock::now/system", samples_, [&] { auto t = seq_clock::now(); (void) t; });
+        if (seq_clock::use(clock_source::tsc)) {
+            run("seq_clock::now/tsc", samples_, [&] { auto t = seq_clock::now(); (void) t; });
+            seq_clock::use(clock_source::system);
+        }
+        std::string out;
+        out.reserve(64);
+        auto now = std::chrono::system_clock::now();
+        run("seq_clock::append_iso8601", samples_, [&] {
+            out.clear();
+            seq_clock::append_iso8601(out, now);
+        });
+    }
+
+    void bench_entry(size_t samples_) {
+        std::unique_ptr<seq_log_entry> entry(
+                seq_log_entry::create("Benchmark {Property0}", seq_context(logging_level::info, make_properties(0), "Benchmark")));
+        run("seq_log_entry::init_time", samples_, [&] { benchmark_access::init_time(*entry); });
+
+        for (size_t count: {0, 4, 16}) {
+            seq_context context(logging_level::info, make_properties(count), "Benchmark");
+            run("seq_log_entry::create/" + std::to_string(count) + " properties", samples_,
+                [&] { delete seq_log_entry::create("Benchmark {Property0}", context); });
+        }
+
+        seq_event_limits limits;
+        limits.max_properties = 8;
+        limits.max_property_value_bytes = 8;
+        seq_context limited_context(logging_level::info, make_properties(16), "Benchmark");
+        run("seq_log_entry::create/16 properties, limited to 8 of 8 bytes", samples_,
+            [&] { delete seq_log_entry::create("Benchmark {Property0}", limited_context, limits); });
+
+        for (size_t count: {0, 4, 16}) {
+            std::unique_ptr<seq_log_entry> e(
+                    seq_log_entry::create("Benchmark {Property0}", seq_context(logging_level::info, make_properties(count), "Benchmark")));
+            run("to_raw_json_entry/" + std::to_string(count) + " properties", samples_,
+                [&] { auto json = e->to_raw_json_entry(); });
+        }
+    }
+
+    void bench_flight_recorder(size_t samples_) {
+        flight_recorder_writer recorder("/tmp/seq_benchmarks.seqf", 16384, 1024);
+        for (size_t count: {0, 4, 16}) {
+            std::unique_ptr<seq_log_entry> entry(
+                    seq_log_entry::create("Benchmark {Property0}", seq_context(logging_level::info, make_properties(count), "Benchmark")));
+            run("flight recorder/" + std::to_string(count) + " properties", samples_, [&] { entry->record_to(recorder); });
+        }
+        std::remove("/tmp/seq_benchmarks.seqf");
+        std::remove("/tmp/seq_benchmarks.seqf.prev");
+    }
+
+    void bench_binary_encoding(size_t samples_) {
+        for (size_t count: {0, 4, 16}) {
+            std::unique_ptr<seq_log_entry> entry(
+                    seq_log_entry::create("Benchmark {Property0}", seq_context(logging_level::info, make_properties(count), "Benchmark")));
+            const auto &e = *entry;
+            std::string path;
+            size_t events = 0;
+            {
+                binary_segment_writer writer("/tmp", "seq_benchmarks", size_t{1} << 40);
+                auto timestamp_ticks = std::chrono::duration_cast<binary_format::ticks>(e.timestamp.time_since_epoch()).count();
+                run("binary encode/" + std::to_string(count) + " properties", samples_, [&] {
+                    writer.begin_event(e.level, timestamp_ticks++, e.message(), e.logger_name, e.property_count());
+                    for (size_t i = 0; i < e.property_count(); ++i) {
+                        auto property = e.property(i);
+                        writer.add_property(property.key, property.value);
+                    }
+                    writer.end_event();
+                    ++events;
+                });
+                writer.flush();
+                path = writer.segment_path();
+            }
+            std::FILE *file = std::fopen(path.c_str(), "rb");
+            std::fseek(file, 0, SEEK_END);
+            std::printf("    %.1f bytes/event binary vs %zu bytes/event CLEF\n",
+                        static_cast<double>(std::ftell(file)) / static_cast<double>(events),
+                        e.to_raw_json_entry().size() + 1);
+            std::fclose(file);
+            std::remove(path.c_str());
+        }
+    }
+
+    /// Several CLEF files flushed per dispatch, as the dispatcher does: blocking write() per file vs io_uring with one
+    /// submission for all of them. Measures the time spent on the dispatcher thread, with the writes completing between
+    /// two dispatches (untimed), as they do with a dispatch interval
+    void bench_file_writes(size_t samples_) {
+        constexpr size_t files = 4;
+        for (size_t chunk_bytes: {4096, 65536}) {
+            const std::string chunk(chunk_bytes, 'x');
+            for (auto backend: {file_write_backend::blocking, file_write_backend::io_uring}) {
+                bool uring = backend == file_write_backend::io_uring;
+                std::vector<std::unique_ptr<rolling_file_writer>> writers;
+                for (size_t i = 0; i < files; ++i) {
+                    writers.push_back(std::make_unique<rolling_file_writer>(
+                            "/tmp/seq_benchmarks_" + std::to_string(i) + ".clef", 0, std::chrono::seconds(0), false,
+                            1024 * 1024, backend));
+                }
+                if (uring && !writers.front()->uses_io_uring()) {
+                    std::printf("    io_uring unavailable, skipped\n");
+                    break;
+                }
+                result r;
+                for (size_t i = 0; i < samples_ / 10; ++i) {
+                    for (auto &writer: writers) writer->write(chunk);
+                    auto allocations_before = allocations;
+                    auto start = clock_type::now();
+                    for (auto &writer: writers) writer->flush();
+                    if (uring) io_uring_write_queue::shared()->submit();
+                    auto elapsed = clock_type::now() - start;
+                    r.allocations += allocations - allocations_before;
+                    ++r.calls;
+                    r.samples_ns.push_back(static_cast<double>(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+                    if (uring) io_uring_write_queue::shared()->wait_all();
+                }
+                report("file flush/" + std::to_string(files) + " files " + std::to_string(chunk_bytes / 1024) + "KB " +
+                       (uring ? "io_uring" : "write()"), r);
+                for (auto &writer: writers) {
+                    auto path = writer->path();
+                    writer.reset();
+                    std::remove(path.c_str());
+                }
+            }
+        }
+    }
+
+    /// Ingestion responses as Seq sends them, received in two segments, parsed into the reused buffer of the parser
+    void bench_http_response(size_t samples_) {
+        const std::string content_length = "HTTP/1.1 201 Created\r\nContent-Type: application/json; charset=utf-8\r\n"
+                                           "Date: Mon, 01 Jan 2024 00:00:00 GMT\r\nContent-Length: 34\r\n\r\n"
+                                           "{\"MinimumLevelAccepted\":\"Warning\"}";
+        const std::string chunked = "HTTP/1.1 201 Created\r\nContent-Type: application/json; charset=utf-8\r\n"
+                                    "Transfer-Encoding: chunked\r\n\r\n22\r\n{\"MinimumLevelAccepted\":\"Warning\"}\r\n0\r\n\r\n";
+        http::ResponseParser parser;
+        for (const auto *response: {&content_length, &chunked}) {
+            run(std::string("http response/") + (response == &chunked ? "chunked" : "content-length"), samples_, [&] {
+                parser.reset();
+                size_t offset = 0;
+                for (size_t part: {response->size() / 2, response->size() - response->size() / 2}) {
+                    auto room = parser.prepare();
+                    std::memcpy(room.first, response->data() + offset, part);
+                    offset += part;
+                    parser.commit(part);
+                }
+            });
+        }
+    }
+
+    void bench_make_context(size_t samples_) {
+        for (size_t count: {0, 4, 16}) {
+            seq logger("BenchmarkProperties", make_properties(count));
+            run("make_context/" + std::to_string(count) + " logger properties", samples_, [&] {
+                auto ctx = benchmark_access::make_context(logger, logging_level::info, {});
+            });
+        }
+        for (size_t count: {0, 4, 16}) {
+            seq logger("BenchmarkEnrichers");
+            for (size_t i = 0; i < count; ++i) {
+                logger.add_enricher([i](seq_context &ctx_) { ctx_.add("Enriched", static_cast<int32_t>(i)); });
+            }
+            run("make_context/" + std::to_string(count) + " enrichers", samples_, [&] {
+                auto ctx = benchmark_access::make_context(logger, logging_level::info, {});
+            });
+        }
+    }
+
+    void bench_child(size_t samples_) {
+        run("seq logger/construct + destroy", samples_, [&] { seq logger("BenchmarkLogger"); });
+        seq parent("BenchmarkParent");
+        run("child logger/construct + destroy", samples_, [&] { auto child = parent.child({{"RequestId", 42}}); });
+        auto registered = seq::get("Benchmark.Registered");
+        run("seq::get/existing logger", samples_, [&] { auto logger = seq::get("Benchmark.Registered"); });
+    }
+
+    void bench_scope(size_t samples_) {
+        stringified_value request_id = 1234567;
+        run("seq_scope/push + pop", samples_, [&] { seq_scope scope("RequestId", request_id); });
+
+        seq_scope request("RequestId", request_id);
+        seq_scope tenant("Tenant", stringified_value("acme"));
+        seq_context context(logging_level::info, make_properties(0), "Benchmark");
+        context.scope = &seq_scope_stack::current();
+        run("seq_log_entry::create/2 scoped properties", samples_,
+            [&] { delete seq_log_entry::create("Benchmark {Property0}", context); });
+    }
+
+    void bench_enqueue(size_t samples_) {
+        auto max_threads = std::max(4u, std::thread::hardware_concurrency());
+        for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+            seq logger("BenchmarkEnqueue", logging_level::fatal, logging_level::verbose);
+            std::vector<result> results(threads);
+            std::vector<std::thread> workers;
+            std::atomic<unsigned> ready{0};
+            for (unsigned t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t] {
+                    ++ready;
+                    while (ready < threads) std::this_thread::yield();
+                    results[t] = measure(samples_, [&] {
+                        benchmark_access::enqueue(logger, "Benchmark {Property0}",
+                                                  seq_context(logging_level::info, make_properties(1), "BenchmarkEnqueue"));
+                    });
+                });
+            }
+            for (auto &worker: workers) worker.join();
+            benchmark_access::drain(logger);
+
+            result merged;
+            for (auto &r: results) {
+                merged.samples_ns.insert(merged.samples_ns.end(), r.samples_ns.begin(), r.samples_ns.end());
+                merged.calls += r.calls;
+                merged.allocations += r.allocations;
+            }
+            report("enqueue/" + std::to_string(threads) + " threads", merged);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t samples = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    seq::base_level_console = logging_level::fatal;
+    seq::base_level_seq = logging_level::verbose;
+
+    std::printf("%-48s %10s %10s %10s %10s\n", "benchmark", "p50 ns", "p99 ns", "p999 ns", "allocs");
+    bench_escape_json(samples);
+    bench_stringified_value(samples);
+    bench_clock(samples);
+    bench_entry(samples);
+    bench_flight_recorder(samples);
+    bench_binary_encoding(samples);
+    bench_file_writes(samples);
+    bench_http_response(samples);
+    bench_make_context(samples);
+    bench_child(samples);
+    bench_scope(samples);
+    bench_enqueue(samples);
+    return 0;
+}
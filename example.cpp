@@ -62,6 +62,13 @@ int main() {
     }
     entity_with_own_logger e1(1);
 
+    seq_logger::seq requests_log("Requests");
+    for (int request_id = 0; request_id < 3; ++request_id) {
+        auto request_log = requests_log.child({{"RequestId", request_id}});
+        request_log.info("Handling request");
+        request_log.debug("Request handled in {ElapsedMs}ms", {{"ElapsedMs", 42}});
+    }
+
     seq::log_verbose("Should not be visible");
     seq::log_warning("Should be visible");
     auto au = additional_unit();
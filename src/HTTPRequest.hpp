@@ -17,6 +17,7 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <system_error>
 #include <type_traits>
 #include <vector>
@@ -44,6 +45,7 @@ extern "C" char *_strdup(const char *strSource);
 #  include <errno.h>
 #  include <fcntl.h>
 #  include <netinet/in.h>
+#  include <netinet/tcp.h>
 #  include <netdb.h>
 #  include <sys/select.h>
 #  include <sys/socket.h>
@@ -178,6 +180,16 @@ namespace http
         std::vector<std::uint8_t> body;
     };
 
+    // Response pointing into the buffer of the ResponseParser that parsed it, valid until the parser is reset
+    struct ResponseView final
+    {
+        Version version{};
+        std::uint16_t code = 0;
+        std::string_view reason;
+        std::vector<std::pair<std::string_view, std::string_view>> headerFields; // names in lower case
+        std::string_view body;
+    };
+
     inline namespace detail
     {
 #if defined(_WIN32) || defined(__CYGWIN__)
@@ -400,6 +412,11 @@ namespace http
                     throw std::system_error{errno, std::system_category(), "Failed to set socket option"};
                 }
 #endif // __APPLE__
+
+                // Requests are written in a few large sends (the head, then body chunks), don't let Nagle's algorithm
+                // hold back a small last one until the previous ones were acknowledged. Best effort
+                const int noDelay = 1;
+                setsockopt(endpoint, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
             }
 
             ~Socket()
@@ -1081,10 +1098,10 @@ namespace http
             return result;
         }
 
-        inline std::vector<std::uint8_t> encodeHtml(const Uri& uri,
-                                                    const std::string& method,
-                                                    const std::vector<uint8_t>& body,
-                                                    HeaderFields headerFields)
+        // Request line and header section, headerFields has to include the Content-Length or Transfer-Encoding
+        inline std::string encodeHead(const Uri& uri,
+                                      const std::string& method,
+                                      HeaderFields headerFields)
         {
             if (uri.scheme != "http")
                 throw RequestError{"Only HTTP scheme is supported"};
@@ -1095,9 +1112,6 @@ namespace http
             // RFC 7230, 5.4. Host
             headerFields.push_back({"Host", uri.host});
 
-            // RFC 7230, 3.3.2. Content-Length
-            headerFields.push_back({"Content-Length", std::to_string(body.size())});
-
             // RFC 7617, 2. The 'Basic' Authentication Scheme
             if (!uri.user.empty() || !uri.password.empty())
             {
@@ -1105,17 +1119,375 @@ namespace http
                 headerFields.push_back({"Authorization", "Basic " + encodeBase64(userinfo.begin(), userinfo.end())});
             }
 
-            const auto headerData = encodeRequestLine(method, requestTarget) +
-                                    encodeHeaderFields(headerFields) +
-                                    "\r\n";
+            return encodeRequestLine(method, requestTarget) +
+                   encodeHeaderFields(headerFields) +
+                   "\r\n";
+        }
 
-            std::vector<uint8_t> result(headerData.begin(), headerData.end());
-            result.insert(result.end(), body.begin(), body.end());
+        template <class Iterator>
+        std::vector<std::uint8_t> encodeHtml(const Uri& uri,
+                                             const std::string& method,
+                                             const Iterator bodyBegin,
+                                             const Iterator bodyEnd,
+                                             HeaderFields headerFields)
+        {
+            // RFC 7230, 3.3.2. Content-Length
+            headerFields.push_back({"Content-Length", std::to_string(std::distance(bodyBegin, bodyEnd))});
+
+            const auto headerData = encodeHead(uri, method, std::move(headerFields));
+
+            std::vector<uint8_t> result;
+            result.reserve(headerData.size() + static_cast<std::size_t>(std::distance(bodyBegin, bodyEnd)));
+            result.insert(result.end(), headerData.begin(), headerData.end());
+            result.insert(result.end(), bodyBegin, bodyEnd);
 
             return result;
         }
     }
 
+    // Incremental parser of an HTTP/1.1 response, fed with what recv() returns. The response is kept in a buffer owned
+    // by the parser that is reused for the next response: chunked bodies are decoded in place (right after the header
+    // section), consumed bytes are compacted away before the buffer grows, and header fields are kept as offsets until
+    // the response is complete. Once the buffer reached the size of the usual response, parsing allocates nothing
+    class ResponseParser final
+    {
+    public:
+        void reset() noexcept
+        {
+            size = 0;
+            readPosition = 0;
+            scanPosition = 0;
+            bodyBegin = 0;
+            bodyEnd = 0;
+            state = State::header;
+            contentLengthReceived = false;
+            contentLength = 0;
+            chunkRemaining = 0;
+            fieldRanges.clear();
+        }
+
+        // Room for at least minimum more bytes to receive into
+        std::pair<std::uint8_t*, std::size_t> prepare(const std::size_t minimum = 4096)
+        {
+            if (buffer.size() - size < minimum && readPosition > bodyEnd)
+            {
+                // Drop the chunk framing consumed so far
+                std::memmove(buffer.data() + bodyEnd, buffer.data() + readPosition, size - readPosition);
+                size -= readPosition - bodyEnd;
+                readPosition = bodyEnd;
+            }
+
+            if (buffer.size() - size < minimum)
+                buffer.resize((std::max)(buffer.size() * 2, size + minimum));
+
+            return {buffer.data() + size, buffer.size() - size};
+        }
+
+        // Parse count bytes received into the room returned by prepare()
+        // Returns true once the response is complete
+        bool commit(const std::size_t count)
+        {
+            size += count;
+
+            if (state == State::header)
+            {
+                constexpr std::array<std::uint8_t, 4> headerEnd = {'\r', '\n', '\r', '\n'};
+                // RFC 7230, 3. Message Format
+                // Empty line indicates the end of the header section (RFC 7230, 2.1. Client/Server Messaging)
+                const auto begin = buffer.cbegin() + static_cast<std::ptrdiff_t>(scanPosition);
+                const auto end = buffer.cbegin() + static_cast<std::ptrdiff_t>(size);
+                const auto i = std::search(begin, end, headerEnd.cbegin(), headerEnd.cend());
+                if (i == end)
+                {
+                    // The terminator may start in the bytes scanned so far
+                    scanPosition = size > 3 ? size - 3 : 0;
+                    return false;
+                }
+
+                parseHeader(static_cast<std::size_t>(i - buffer.cbegin()) + 2);
+            }
+
+            return parseBody();
+        }
+
+        // The connection was closed by the server
+        // Returns true if that completes the response (its body is delimited by the end of the connection)
+        bool finish()
+        {
+            if (state == State::identity && !contentLengthReceived)
+            {
+                bodyEnd = size;
+                complete();
+            }
+
+            return state == State::complete;
+        }
+
+        const ResponseView& view() const noexcept
+        {
+            return response;
+        }
+
+    private:
+        enum class State
+        {
+            header,
+            identity,
+            chunkSize,
+            chunkData,
+            chunkDataEnd,
+            trailer,
+            complete
+        };
+
+        struct FieldRange
+        {
+            std::size_t nameBegin;
+            std::size_t nameEnd;
+            std::size_t valueBegin;
+            std::size_t valueEnd;
+        };
+
+        char at(const std::size_t position) const noexcept
+        {
+            return static_cast<char>(buffer[position]);
+        }
+
+        std::size_t findCrlf(std::size_t position, const std::size_t end) const noexcept
+        {
+            for (; position + 1 < end; ++position)
+                if (buffer[position] == '\r' && buffer[position + 1] == '\n')
+                    return position;
+
+            return end;
+        }
+
+        std::string_view slice(const std::size_t begin, const std::size_t end) const noexcept
+        {
+            return {reinterpret_cast<const char*>(buffer.data()) + begin, end - begin};
+        }
+
+        // RFC 7230, 3.1.2. Status Line and 3.2. Header Fields, headerEnd is the end of the last field line
+        void parseHeader(const std::size_t headerEnd)
+        {
+            std::size_t i = 0;
+            const auto expect = [this, &i, headerEnd](const char c, const char* error) {
+                if (i >= headerEnd || at(i++) != c)
+                    throw ResponseError{error};
+            };
+
+            for (const char c : {'H', 'T', 'T', 'P', '/'})
+                expect(c, "Invalid HTTP version");
+
+            if (i >= headerEnd)
+                throw ResponseError{"Invalid HTTP version"};
+            response.version.major = digitToUint<std::uint16_t>(at(i++));
+            expect('.', "Invalid HTTP version");
+            if (i >= headerEnd)
+                throw ResponseError{"Invalid HTTP version"};
+            response.version.minor = digitToUint<std::uint16_t>(at(i++));
+            expect(' ', "Invalid status line");
+
+            response.code = 0;
+            const auto codeBegin = i;
+            for (; i < headerEnd && isDigitChar(at(i)); ++i)
+                response.code = static_cast<std::uint16_t>(response.code * 10U + digitToUint<std::uint16_t>(at(i)));
+            if (i - codeBegin != 3)
+                throw ResponseError{"Invalid status code"};
+            expect(' ', "Invalid status line");
+
+            const auto reasonBegin = i;
+            i = findCrlf(i, headerEnd);
+            reasonEnd = i;
+            reasonStart = reasonBegin;
+            i += 2;
+
+            while (i < headerEnd)
+            {
+                FieldRange range{};
+                range.nameBegin = i;
+                for (; i < headerEnd && isTokenChar(at(i)); ++i)
+                    buffer[i] = static_cast<std::uint8_t>(toLower(at(i)));
+                range.nameEnd = i;
+                if (range.nameBegin == range.nameEnd)
+                    throw ResponseError{"Invalid token"};
+                expect(':', "Invalid header");
+
+                for (; i < headerEnd && isWhiteSpaceChar(at(i)); ++i);
+                range.valueBegin = i;
+
+                for (;;)
+                {
+                    i = findCrlf(i, headerEnd);
+                    // Obsolete folding (RFC 7230, 3.2.4. Field Parsing) is replaced with spaces in place
+                    if (i + 2 < headerEnd && isWhiteSpaceChar(at(i + 2)))
+                    {
+                        buffer[i] = ' ';
+                        buffer[i + 1] = ' ';
+                        continue;
+                    }
+                    break;
+                }
+
+                range.valueEnd = i;
+                while (range.valueEnd > range.valueBegin && isWhiteSpaceChar(at(range.valueEnd - 1)))
+                    --range.valueEnd;
+                i += 2;
+
+                const auto name = slice(range.nameBegin, range.nameEnd);
+                const auto value = slice(range.valueBegin, range.valueEnd);
+                if (name == "transfer-encoding")
+                {
+                    // RFC 7230, 3.3.1. Transfer-Encoding
+                    if (value.size() != 7 || !std::equal(value.begin(), value.end(), "chunked",
+                                                         [](const char l, const char r) noexcept {
+                                                             return toLower(l) == r;
+                                                         }))
+                        throw ResponseError{"Unsupported transfer encoding: " + std::string{value}};
+                    state = State::chunkSize;
+                }
+                else if (name == "content-length")
+                {
+                    // RFC 7230, 3.3.2. Content-Length
+                    contentLength = stringToUint<std::size_t>(value.begin(), value.end());
+                    contentLengthReceived = true;
+                }
+
+                fieldRanges.push_back(range);
+            }
+
+            bodyBegin = bodyEnd = readPosition = headerEnd + 2;
+
+            // Content-Length must be ignored if Transfer-Encoding is received (RFC 7230, 3.2. Content-Length)
+            if (state != State::chunkSize)
+                state = State::identity;
+
+            // RFC 7230, 3.3.3. Message Body Length
+            if (response.code / 100 == 1 || response.code == 204 || response.code == 304)
+            {
+                contentLengthReceived = true;
+                contentLength = 0;
+                state = State::identity;
+            }
+        }
+
+        bool parseBody()
+        {
+            for (;;)
+            {
+                switch (state)
+                {
+                    case State::identity:
+                        readPosition = size;
+                        bodyEnd = size;
+                        if (contentLengthReceived && bodyEnd - bodyBegin >= contentLength)
+                        {
+                            bodyEnd = bodyBegin + contentLength;
+                            complete();
+                            return true;
+                        }
+                        return false;
+
+                    // RFC 7230, 4.1. Chunked Transfer Coding
+                    case State::chunkSize:
+                    {
+                        const auto lineEnd = findCrlf(readPosition, size);
+                        if (lineEnd == size)
+                            return false;
+
+                        // Chunk extensions are ignored
+                        auto sizeEnd = readPosition;
+                        while (sizeEnd < lineEnd && at(sizeEnd) != ';' && !isWhiteSpaceChar(at(sizeEnd)))
+                            ++sizeEnd;
+                        if (sizeEnd == readPosition)
+                            throw ResponseError{"Invalid chunk size"};
+                        chunkRemaining = hexStringToUint<std::size_t>(buffer.cbegin() + static_cast<std::ptrdiff_t>(readPosition),
+                                                                      buffer.cbegin() + static_cast<std::ptrdiff_t>(sizeEnd));
+                        readPosition = lineEnd + 2;
+                        state = chunkRemaining > 0 ? State::chunkData : State::trailer;
+                        break;
+                    }
+
+                    case State::chunkData:
+                    {
+                        const auto available = (std::min)(chunkRemaining, size - readPosition);
+                        if (available == 0)
+                            return false;
+
+                        if (bodyEnd != readPosition)
+                            std::memmove(buffer.data() + bodyEnd, buffer.data() + readPosition, available);
+                        bodyEnd += available;
+                        readPosition += available;
+                        chunkRemaining -= available;
+                        if (chunkRemaining > 0)
+                            return false;
+
+                        state = State::chunkDataEnd;
+                        break;
+                    }
+
+                    case State::chunkDataEnd:
+                        if (size - readPosition < 2)
+                            return false;
+                        if (at(readPosition) != '\r' || at(readPosition + 1) != '\n')
+                            throw ResponseError{"Invalid chunk"};
+                        readPosition += 2;
+                        state = State::chunkSize;
+                        break;
+
+                    case State::trailer:
+                    {
+                        // RFC 7230, 4.1.2. Chunked Trailer Part, ends with an empty line
+                        const auto lineEnd = findCrlf(readPosition, size);
+                        if (lineEnd == size)
+                            return false;
+
+                        const auto empty = lineEnd == readPosition;
+                        readPosition = lineEnd + 2;
+                        if (empty)
+                        {
+                            complete();
+                            return true;
+                        }
+                        break;
+                    }
+
+                    case State::complete:
+                        return true;
+
+                    case State::header:
+                        return false;
+                }
+            }
+        }
+
+        void complete()
+        {
+            state = State::complete;
+            response.reason = slice(reasonStart, reasonEnd);
+            response.headerFields.clear();
+            for (const auto& range : fieldRanges)
+                response.headerFields.emplace_back(slice(range.nameBegin, range.nameEnd),
+                                                   slice(range.valueBegin, range.valueEnd));
+            response.body = slice(bodyBegin, bodyEnd);
+        }
+
+        std::vector<std::uint8_t> buffer;
+        std::size_t size = 0; // bytes received into buffer
+        std::size_t readPosition = 0; // bytes parsed
+        std::size_t scanPosition = 0; // where to continue looking for the end of the header section
+        std::size_t reasonStart = 0;
+        std::size_t reasonEnd = 0;
+        std::size_t bodyBegin = 0;
+        std::size_t bodyEnd = 0; // end of the (de-chunked) body received so far
+        State state = State::header;
+        bool contentLengthReceived = false;
+        std::size_t contentLength = 0;
+        std::size_t chunkRemaining = 0;
+        std::vector<FieldRange> fieldRanges;
+        ResponseView response;
+    };
+
     class Request final
     {
     public:
@@ -1131,16 +1503,126 @@ namespace http
                       const HeaderFields& headerFields = {},
                       const std::chrono::milliseconds timeout = std::chrono::milliseconds{-1})
         {
-            return send(method,
-                        std::vector<uint8_t>(body.begin(), body.end()),
-                        headerFields,
-                        timeout);
+            ResponseParser parser;
+            exchange(method, body.begin(), body.end(), headerFields, timeout, parser);
+            return toResponse(parser.view());
         }
 
         Response send(const std::string& method,
                       const std::vector<uint8_t>& body,
                       const HeaderFields& headerFields = {},
                       const std::chrono::milliseconds timeout = std::chrono::milliseconds{-1})
+        {
+            ResponseParser parser;
+            exchange(method, body.begin(), body.end(), headerFields, timeout, parser);
+            return toResponse(parser.view());
+        }
+
+        // Same as send(), but the response is parsed into a buffer owned by this Request and reused by the next call,
+        // so receiving allocates nothing once the buffer fits the usual response. The view is valid until the next
+        // call; not thread safe
+        const ResponseView& sendInPlace(const std::string& method,
+                                        std::string_view body,
+                                        const HeaderFields& headerFields = {},
+                                        const std::chrono::milliseconds timeout = std::chrono::milliseconds{-1})
+        {
+            exchange(method, body.begin(), body.end(), headerFields, timeout, responseParser);
+            return responseParser.view();
+        }
+
+        // Sends the body with chunked transfer coding (RFC 7230, 4.1) while it is being produced, so that it never is
+        // in memory as a whole. nextChunk(std::string& buffer) is called until it returns false, it appends the next
+        // part of the body to buffer (its capacity is kept, also for the next request) and returns whether more
+        // follows. Every call with data is sent as one chunk. The response is parsed as with sendInPlace()
+        template <class ChunkWriter>
+        const ResponseView& sendChunkedInPlace(const std::string& method,
+                                               ChunkWriter&& nextChunk,
+                                               HeaderFields headerFields = {},
+                                               const std::chrono::milliseconds timeout = std::chrono::milliseconds{-1})
+        {
+            if (uri.scheme != "http")
+                throw RequestError{"Only HTTP scheme is supported"};
+
+            // RFC 7230, 3.3.1. Transfer-Encoding
+            headerFields.push_back({"Transfer-Encoding", "chunked"});
+            const auto head = encodeHead(uri, method, std::move(headerFields));
+
+            exchange(timeout, responseParser, [&](const auto& sendAll) {
+                sendAll(head.data(), head.size());
+
+                // Room for the chunk size line (and the line break ending the previous chunk) in front of the data
+                constexpr std::size_t sizeLineRoom = 2 + 16 + 2;
+                constexpr char hexDigits[] = "0123456789ABCDEF";
+                bool first = true;
+                for (bool more = true; more;)
+                {
+                    chunkBuffer.assign(sizeLineRoom, '\0');
+                    more = nextChunk(chunkBuffer);
+
+                    auto dataSize = chunkBuffer.size() - sizeLineRoom;
+                    auto begin = sizeLineRoom;
+                    if (dataSize > 0)
+                    {
+                        chunkBuffer[--begin] = '\n';
+                        chunkBuffer[--begin] = '\r';
+                        do chunkBuffer[--begin] = hexDigits[dataSize % 16];
+                        while ((dataSize /= 16) > 0);
+                        if (!first)
+                        {
+                            chunkBuffer[--begin] = '\n';
+                            chunkBuffer[--begin] = '\r';
+                        }
+                        first = false;
+                    }
+
+                    // The last chunk goes out with the data of the final call
+                    if (!more)
+                        chunkBuffer += first ? "0\r\n\r\n" : "\r\n0\r\n\r\n";
+
+                    if (chunkBuffer.size() > begin)
+                        sendAll(chunkBuffer.data() + begin, chunkBuffer.size() - begin);
+                }
+            });
+
+            return responseParser.view();
+        }
+
+    private:
+#if defined(_WIN32) || defined(__CYGWIN__)
+        winsock::Api winSock;
+#endif // defined(_WIN32) || defined(__CYGWIN__)
+        static Response toResponse(const ResponseView& view)
+        {
+            Response response;
+            response.status = Status{view.version, view.code, std::string{view.reason}};
+            response.headerFields.reserve(view.headerFields.size());
+            for (const auto& field : view.headerFields)
+                response.headerFields.push_back({std::string{field.first}, std::string{field.second}});
+            response.body.assign(view.body.begin(), view.body.end());
+            return response;
+        }
+
+        template <class Iterator>
+        void exchange(const std::string& method,
+                      const Iterator bodyBegin,
+                      const Iterator bodyEnd,
+                      const HeaderFields& headerFields,
+                      const std::chrono::milliseconds timeout,
+                      ResponseParser& parser)
+        {
+            const auto requestData = encodeHtml(uri, method, bodyBegin, bodyEnd, headerFields);
+
+            exchange(timeout, parser, [&requestData](const auto& sendAll) {
+                sendAll(requestData.data(), requestData.size());
+            });
+        }
+
+        // Connects, lets sendRequest write the request through the sendAll(const void*, std::size_t) it is passed and
+        // parses the response with parser
+        template <class RequestSender>
+        void exchange(const std::chrono::milliseconds timeout,
+                      ResponseParser& parser,
+                      RequestSender&& sendRequest)
         {
             const auto stopTime = std::chrono::steady_clock::now() + timeout;
 
@@ -1163,8 +1645,6 @@ namespace http
 
             const std::unique_ptr<addrinfo, decltype(&freeaddrinfo)> addressInfo{info, freeaddrinfo};
 
-            const auto requestData = encodeHtml(uri, method, body, headerFields);
-
             Socket socket{internetProtocol};
 
             const auto getRemainingMilliseconds = [](const std::chrono::steady_clock::time_point time) noexcept -> std::int64_t {
@@ -1177,157 +1657,41 @@ namespace http
             socket.connect(addressInfo->ai_addr, static_cast<socklen_t>(addressInfo->ai_addrlen),
                            (timeout.count() >= 0) ? getRemainingMilliseconds(stopTime) : -1);
 
-            auto remaining = requestData.size();
-            auto sendData = requestData.data();
-
             // send the request
-            while (remaining > 0)
-            {
-                const auto size = socket.send(sendData, remaining,
-                                              (timeout.count() >= 0) ? getRemainingMilliseconds(stopTime) : -1);
-                remaining -= size;
-                sendData += size;
-            }
-
-            std::array<std::uint8_t, 4096> tempBuffer;
-            constexpr std::array<std::uint8_t, 2> crlf = {'\r', '\n'};
-            constexpr std::array<std::uint8_t, 4> headerEnd = {'\r', '\n', '\r', '\n'};
-            Response response;
-            std::vector<std::uint8_t> responseData;
-            bool parsingBody = false;
-            bool contentLengthReceived = false;
-            std::size_t contentLength = 0U;
-            bool chunkedResponse = false;
-            std::size_t expectedChunkSize = 0U;
-            bool removeCrlfAfterChunk = false;
+            sendRequest([&](const void* data, std::size_t remaining) {
+                auto sendData = static_cast<const std::uint8_t*>(data);
+                while (remaining > 0)
+                {
+                    const auto size = socket.send(sendData, remaining,
+                                                  (timeout.count() >= 0) ? getRemainingMilliseconds(stopTime) : -1);
+                    remaining -= size;
+                    sendData += size;
+                }
+            });
 
             // read the response
+            parser.reset();
             for (;;)
             {
-                const auto size = socket.recv(tempBuffer.data(), tempBuffer.size(),
+                const auto space = parser.prepare();
+                const auto size = socket.recv(space.first, space.second,
                                               (timeout.count() >= 0) ? getRemainingMilliseconds(stopTime) : -1);
                 if (size == 0) // disconnected
-                    return response;
-
-                responseData.insert(responseData.end(), tempBuffer.begin(), tempBuffer.begin() + size);
-
-                if (!parsingBody)
                 {
-                    // RFC 7230, 3. Message Format
-                    // Empty line indicates the end of the header section (RFC 7230, 2.1. Client/Server Messaging)
-                    const auto endIterator = std::search(responseData.cbegin(), responseData.cend(),
-                                                         headerEnd.cbegin(), headerEnd.cend());
-                    if (endIterator == responseData.cend()) break; // two consecutive CRLFs not found
-
-                    const auto headerBeginIterator = responseData.cbegin();
-                    const auto headerEndIterator = endIterator + 2;
-
-                    auto statusLineResult = parseStatusLine(headerBeginIterator, headerEndIterator);
-                    auto i = statusLineResult.first;
-
-                    response.status = std::move(statusLineResult.second);
-
-                    for (;;)
-                    {
-                        auto headerFieldResult = parseHeaderField(i, headerEndIterator);
-                        i = headerFieldResult.first;
-
-                        auto fieldName = std::move(headerFieldResult.second.first);
-                        auto fieldValue = std::move(headerFieldResult.second.second);
-
-                        if (fieldName == "transfer-encoding")
-                        {
-                            // RFC 7230, 3.3.1. Transfer-Encoding
-                            if (fieldValue == "chunked")
-                                chunkedResponse = true;
-                            else
-                                throw ResponseError{"Unsupported transfer encoding: " + fieldValue};
-                        }
-                        else if (fieldName == "content-length")
-                        {
-                            // RFC 7230, 3.3.2. Content-Length
-                            contentLength = stringToUint<std::size_t>(fieldValue.cbegin(), fieldValue.cend());
-                            contentLengthReceived = true;
-                            response.body.reserve(contentLength);
-                        }
-
-                        response.headerFields.push_back({std::move(fieldName), std::move(fieldValue)});
-
-                        if (i == headerEndIterator)
-                            break;
-                    }
-
-                    responseData.erase(responseData.cbegin(), headerEndIterator + 2);
-                    parsingBody = true;
+                    if (parser.finish())
+                        return;
+                    throw ResponseError{"Connection closed before the response was complete"};
                 }
 
-                if (parsingBody)
-                {
-                    // Content-Length must be ignored if Transfer-Encoding is received (RFC 7230, 3.2. Content-Length)
-                    if (chunkedResponse)
-                    {
-                        // RFC 7230, 4.1. Chunked Transfer Coding
-                        for (;;)
-                        {
-                            if (expectedChunkSize > 0)
-                            {
-                                const auto toWrite = (std::min)(expectedChunkSize, responseData.size());
-                                response.body.insert(response.body.end(), responseData.begin(),
-                                                     responseData.begin() + static_cast<std::ptrdiff_t>(toWrite));
-                                responseData.erase(responseData.begin(),
-                                                   responseData.begin() + static_cast<std::ptrdiff_t>(toWrite));
-                                expectedChunkSize -= toWrite;
-
-                                if (expectedChunkSize == 0) removeCrlfAfterChunk = true;
-                                if (responseData.empty()) break;
-                            }
-                            else
-                            {
-                                if (removeCrlfAfterChunk)
-                                {
-                                    if (responseData.size() < 2) break;
-
-                                    if (!std::equal(crlf.begin(), crlf.end(), responseData.begin()))
-                                        throw ResponseError{"Invalid chunk"};
-
-                                    removeCrlfAfterChunk = false;
-                                    responseData.erase(responseData.begin(), responseData.begin() + 2);
-                                }
-
-                                const auto i = std::search(responseData.begin(), responseData.end(),
-                                                           crlf.begin(), crlf.end());
-
-                                if (i == responseData.end()) break;
-
-                                expectedChunkSize = detail::hexStringToUint<std::size_t>(responseData.begin(), i);
-                                responseData.erase(responseData.begin(), i + 2);
-
-                                if (expectedChunkSize == 0)
-                                    return response;
-                            }
-                        }
-                    }
-                    else
-                    {
-                        response.body.insert(response.body.end(), responseData.begin(), responseData.end());
-                        responseData.clear();
-
-                        // got the whole content
-                        if (contentLengthReceived && response.body.size() >= contentLength)
-                            return response;
-                    }
-                }
+                if (parser.commit(size))
+                    return;
             }
-
-            return response;
         }
 
-    private:
-#if defined(_WIN32) || defined(__CYGWIN__)
-        winsock::Api winSock;
-#endif // defined(_WIN32) || defined(__CYGWIN__)
         InternetProtocol internetProtocol;
         Uri uri;
+        ResponseParser responseParser;
+        std::string chunkBuffer;
     };
 }
 
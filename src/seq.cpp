@@ -0,0 +1,7 @@
+// Compiled part of the seq_logger library, see SEQ_LOGGER_COMPILED_LIB in seq.hpp
+
+#ifndef SEQ_LOGGER_COMPILED_LIB
+#  error Define SEQ_LOGGER_COMPILED_LIB to build seq.cpp (the seq_logger CMake target does)
+#endif // SEQ_LOGGER_COMPILED_LIB
+
+#include "seq_impl.hpp"
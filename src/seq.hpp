@@ -1,58 +1,92 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
-#include <iomanip>
-#include <iostream>
 #include <chrono>
 #include <condition_variable>
+#include <cctype>
+#include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
-#include <sstream>
+#include <ostream>
+#include <stdexcept>
 #include <string>
-#include <thread>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
-#include "HTTPRequest.hpp"
+#include "seq_clock.hpp"
+
+// With SEQ_LOGGER_COMPILED_LIB the HTTP client, file outputs and dispatcher are compiled once into the seq_logger
+// library (src/seq.cpp) instead of into every translation unit including this header, which then only needs the
+// standard library (see tests/compiled_header_check.cpp)
+#ifdef SEQ_LOGGER_COMPILED_LIB
+#  define SEQ_LOGGER_INLINE
+#else
+#  define SEQ_LOGGER_INLINE inline
+#endif // SEQ_LOGGER_COMPILED_LIB
 
 namespace seq_logger {
+    ///\brief Grants the benchmark suite (benchmarks/seq_benchmarks.cpp) access to internals, not part of the API
+    struct benchmark_access;
+
     struct helpers {
-        static inline std::string escape_json(const std::string &s) {
-            std::ostringstream o;
-            for (char c: s) {
+        ///\brief Append s_ to out_, escaped for use inside a JSON string
+        static inline void append_escaped_json(std::string &out_, std::string_view s_) {
+            static const char hex[] = "0123456789abcdef";
+            for (char c: s_) {
                 switch (c) {
                     case '"':
-                        o << "\\\"";
+                        out_ += "\\\"";
                         break;
                     case '\\':
-                        o << "\\\\";
+                        out_ += "\\\\";
                         break;
                     case '\b':
-                        o << "\\b";
+                        out_ += "\\b";
                         break;
                     case '\f':
-                        o << "\\f";
+                        out_ += "\\f";
                         break;
                     case '\n':
-                        o << "\\n";
+                        out_ += "\\n";
                         break;
                     case '\r':
-                        o << "\\r";
+                        out_ += "\\r";
                         break;
                     case '\t':
-                        o << "\\t";
+                        out_ += "\\t";
                         break;
                     default:
                         if ('\x00' <= c && c <= '\x1f') {
-                            o << "\\u"
-                              << std::hex << std::setw(4) << std::setfill('0') << (int) c;
+                            out_ += "\\u00";
+                            out_ += hex[(c >> 4) & 0xF];
+                            out_ += hex[c & 0xF];
                         } else {
-                            o << c;
+                            out_ += c;
                         }
                 }
             }
-            return o.str();
+        }
+
+        static inline std::string escape_json(std::string_view s) {
+            std::string o;
+            o.reserve(s.size());
+            append_escaped_json(o, s);
+            return o;
+        }
+
+        ///\brief Length of the longest prefix of s_ with at most max_bytes_ bytes that does not end inside a UTF-8 sequence
+        static inline size_t utf8_prefix_length(std::string_view s_, size_t max_bytes_) {
+            if (s_.size() <= max_bytes_) return s_.size();
+            auto length = max_bytes_;
+            while (length > 0 && (static_cast<unsigned char>(s_[length]) & 0xC0) == 0x80) --length;
+            return length;
         }
     };
 
@@ -107,6 +141,73 @@ namespace seq_logger {
             "ERR",
             "FTL"};
 
+    ///\brief Seq name of a level stored as a number (e.g. in binary or flight recorder files), values above fatal are
+    /// named Fatal
+    inline const char *logging_level_string(unsigned level_) {
+        return logging_level_strings[std::min<unsigned>(level_, logging_level::fatal)];
+    }
+
+    ///\brief Parse a level name as used by Seq (e.g. "Information"), its short form ("INF") or an abbreviation of at
+    /// least 3 letters ("info", "warn"), ignoring case
+    ///\return false if the name is unknown, level_ is left unchanged then
+    inline bool try_parse_logging_level(std::string_view name_, logging_level &level_) {
+        auto matches = [&](const char *candidate_, bool prefix_) {
+            size_t length = std::strlen(candidate_);
+            if (name_.size() > length || (prefix_ ? name_.size() < 3 : name_.size() != length)) return false;
+            for (size_t i = 0; i < name_.size(); ++i) {
+                if (std::tolower(static_cast<unsigned char>(name_[i])) != std::tolower(static_cast<unsigned char>(candidate_[i]))) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        for (int i = logging_level::verbose; i <= logging_level::fatal; ++i) {
+            if (matches(logging_level_strings[i], true) || matches(logging_level_strings_short[i], false)) {
+                level_ = static_cast<logging_level>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    ///\brief Parse a level name, see try_parse_logging_level. Returns fallback_ if the name is unknown
+    inline logging_level parse_logging_level(std::string_view name_, logging_level fallback_) {
+        try_parse_logging_level(name_, fallback_);
+        return fallback_;
+    }
+
+    ///\brief Levels for loggers with names matching a glob pattern, see seq::watch_level_config
+    struct seq_level_rule {
+        std::string pattern;
+        logging_level console;
+        logging_level seq;
+    };
+
+    ///\brief Parse level rules, one per line or separated by ';': "pattern = level" or "pattern = console_level, seq_level",
+    /// e.g. "Billing.* = debug" or "*.Http = warn, info". Text after '#' is ignored, invalid rules are reported to
+    /// std::cerr (prefixed with origin_) and skipped
+    SEQ_LOGGER_INLINE std::vector<seq_level_rule> parse_level_rules(std::string_view text_, std::string_view origin_);
+
+    ///\brief Stream buffer appending to a string, lets stringified_value use operator<< without <sstream>
+    class string_append_buffer : public std::streambuf {
+    public:
+        explicit string_append_buffer(std::string &out_) : _out(out_) {}
+
+    protected:
+        int_type overflow(int_type c_) override {
+            if (!traits_type::eq_int_type(c_, traits_type::eof())) _out += traits_type::to_char_type(c_);
+            return traits_type::not_eof(c_);
+        }
+
+        std::streamsize xsputn(const char *s_, std::streamsize count_) override {
+            _out.append(s_, static_cast<size_t>(count_));
+            return count_;
+        }
+
+    private:
+        std::string &_out;
+    };
+
     struct stringified_value {
         stringified_value() = default;
 
@@ -130,16 +231,16 @@ namespace seq_logger {
 
         template<class T>
         stringified_value(T value_) {
-            std::ostringstream ss;
-            ss << value_;
-            str_val = ss.str();
+            string_append_buffer buffer(str_val);
+            std::ostream stream(&buffer);
+            stream << value_;
         }
 
         template<class T>
         explicit stringified_value(const T &value_) {
-            std::ostringstream ss;
-            ss << value_;
-            str_val = ss.str();
+            string_append_buffer buffer(str_val);
+            std::ostream stream(&buffer);
+            stream << value_;
         }
 
         std::string str_val;
@@ -148,8 +249,106 @@ namespace seq_logger {
     typedef std::pair<std::string, stringified_value> seq_properties_pair_t;
     typedef std::vector<seq_properties_pair_t> seq_properties_vector_t;
 
+    ///\brief Thread-local stack of properties attached to everything the thread logs, see seq_scope.
+    /// Properties are kept both raw (for console and binary outputs) and as pre-escaped CLEF fragments, in buffers
+    /// that keep their capacity, so pushing does not allocate once the buffers have grown to the usual depth
+    class seq_scope_stack {
+    public:
+        struct span {
+            uint32_t key_offset;
+            uint32_t key_length;
+            uint32_t value_length;
+        };
+
+        struct marker {
+            size_t raw;
+            size_t spans;
+            size_t escaped;
+        };
+
+        [[nodiscard]] static seq_scope_stack &current() {
+            thread_local seq_scope_stack stack;
+            return stack;
+        }
+
+        marker push(std::string_view key_, std::string_view value_) {
+            marker previous{_raw.size(), _spans.size(), _escaped.size()};
+            _spans.push_back({static_cast<uint32_t>(_raw.size()), static_cast<uint32_t>(key_.size()),
+                              static_cast<uint32_t>(value_.size())});
+            _raw.append(key_);
+            _raw.append(value_);
+            _escaped += ",\"";
+            helpers::append_escaped_json(_escaped, key_);
+            _escaped += "\":\"";
+            helpers::append_escaped_json(_escaped, value_);
+            _escaped += '"';
+            return previous;
+        }
+
+        void pop(const marker &marker_) {
+            _raw.resize(marker_.raw);
+            _spans.resize(marker_.spans);
+            _escaped.resize(marker_.escaped);
+        }
+
+        [[nodiscard]] bool empty() const { return _spans.empty(); }
+
+        [[nodiscard]] size_t size() const { return _spans.size(); }
+
+        [[nodiscard]] const std::vector<span> &spans() const { return _spans; }
+
+        ///\brief Keys and values, back to back, as referenced by spans()
+        [[nodiscard]] std::string_view raw() const { return _raw; }
+
+        ///\brief Properties as CLEF, e.g. ,"RequestId":"42","Tenant":"acme"
+        [[nodiscard]] std::string_view escaped() const { return _escaped; }
+
+    private:
+        seq_scope_stack() {
+            _raw.reserve(1024);
+            _spans.reserve(32);
+            _escaped.reserve(1536);
+        }
+
+        std::string _raw;
+        std::vector<span> _spans;
+        std::string _escaped;
+    };
+
+    ///\brief Adds properties to everything the current thread logs until the guard goes out of scope, e.g.
+    /// seq_scope request_scope("RequestId", request_id);
+    class seq_scope {
+    public:
+        seq_scope(std::string_view key_, const stringified_value &value_)
+                : _marker(seq_scope_stack::current().push(key_, value_.str_val)) {}
+
+        explicit seq_scope(const seq_properties_vector_t &properties_) : _marker(push_all(properties_)) {}
+
+        ~seq_scope() {
+            seq_scope_stack::current().pop(_marker);
+        }
+
+        seq_scope(seq_scope const &) = delete;
+
+        seq_scope &operator=(seq_scope const &) = delete;
+
+    private:
+        static seq_scope_stack::marker push_all(const seq_properties_vector_t &properties_) {
+            auto &stack = seq_scope_stack::current();
+            seq_scope_stack::marker previous{stack.raw().size(), stack.size(), stack.escaped().size()};
+            for (const auto &property: properties_) {
+                stack.push(property.first, property.second.str_val);
+            }
+            return previous;
+        }
+
+        seq_scope_stack::marker _marker;
+    };
+
     class seq_log_entry;
 
+    class flight_recorder_writer;
+
     struct seq_context {
     public:
         const seq_properties_pair_t &operator[](size_t index_) const {
@@ -172,10 +371,10 @@ namespace seq_logger {
 
         [[nodiscard]] size_t size() const { return _properties.size(); };
 
-        seq_context(logging_level level_, seq_properties_vector_t &&parameters_, const char *logger_name_) : level(
+        seq_context(logging_level level_, seq_properties_vector_t &&parameters_, std::string_view logger_name_) : level(
                 level_), logger_name(logger_name_), _properties(std::move(parameters_)) {};
 
-        seq_context(logging_level level_, const seq_properties_vector_t &parameters_, const char *logger_name_)
+        seq_context(logging_level level_, const seq_properties_vector_t &parameters_, std::string_view logger_name_)
                 : level(level_), logger_name(logger_name_), _properties(parameters_) {};
 
         ///\brief Add a property to the context
@@ -186,100 +385,717 @@ namespace seq_logger {
         ///\brief Level of the context
         logging_level level;
 
-        ///\brief Name of the logger
-        const std::string logger_name;
+        ///\brief Name of the logger creating the context, which outlives it
+        const std::string_view logger_name;
+
+        ///\brief Scoped properties of the logging thread (see seq_scope), copied into the event when it is created
+        const seq_scope_stack *scope{nullptr};
     private:
         seq_properties_vector_t _properties;
     };
 
 
-    class seq_log_entry {
+    ///\brief Size limits applied to every event as it is created, see seq::set_event_limits. Zero means unlimited
+    struct seq_event_limits {
+        ///\brief Appended to messages and property values that were cut
+        static constexpr std::string_view truncation_marker{"...[truncated]"};
+        ///\brief Property added (on top of max_properties) with the number of properties that were dropped
+        static constexpr std::string_view dropped_properties_key{"DroppedProperties"};
+
+        ///\brief Longer messages (templates) are cut to this many bytes, followed by truncation_marker
+        size_t max_message_bytes{0};
+        ///\brief Properties beyond this count are dropped, last ones first. Scoped properties (see seq_scope) are
+        /// kept or dropped as a whole
+        size_t max_properties{0};
+        ///\brief Longer property values are cut to this many bytes, followed by truncation_marker. Does not apply to
+        /// scoped properties
+        size_t max_property_value_bytes{0};
+    };
+
+    ///\brief Property of a queued event, pointing into the event's storage
+    struct seq_property_view {
+        std::string_view key;
+        std::string_view value;
+    };
+
+    ///\brief Queued log event. Created with create(), which lays out the message, property keys and values in the
+    /// same allocation, right after the object: [seq_log_entry][property spans][message][key0 value0 key1 value1...]
+    class seq_log_entry final {
     public:
+        ///\brief Build an event from the message and its (enriched) context with a single allocation, applying
+        /// limits_ (see truncated()), release it with delete
+        static seq_log_entry *create(std::string_view message_, const seq_context &context_,
+                                     const seq_event_limits &limits_ = {}) {
+            auto count = context_.size();
+            size_t scope_count = 0;
+            std::string_view scope_raw, scope_escaped;
+            if (context_.scope != nullptr && !context_.scope->empty()) {
+                scope_count = context_.scope->size();
+                scope_raw = context_.scope->raw();
+                scope_escaped = context_.scope->escaped();
+            }
+            // Scoped properties are copied as a block, so they are dropped as a whole if they do not fit
+            size_t dropped = 0;
+            if (limits_.max_properties > 0 && count + scope_count > limits_.max_properties) {
+                if (count > limits_.max_properties) {
+                    dropped = count - limits_.max_properties;
+                    count = limits_.max_properties;
+                }
+                if (count + scope_count > limits_.max_properties) {
+                    dropped += scope_count;
+                    scope_count = 0;
+                    scope_raw = scope_escaped = {};
+                }
+            }
+            std::string dropped_value = dropped > 0 ? std::to_string(dropped) : std::string();
+            size_t dropped_bytes = dropped > 0 ? seq_event_limits::dropped_properties_key.size() + dropped_value.size() : 0;
+            auto property_count = count + (dropped > 0 ? 1 : 0) + scope_count;
+
+            size_t text_bytes = limited_size(message_, limits_.max_message_bytes) + dropped_bytes + scope_raw.size() +
+                                scope_escaped.size();
+            for (size_t i = 0; i < count; ++i) {
+                text_bytes += context_[i].first.size() +
+                              limited_size(context_[i].second.str_val, limits_.max_property_value_bytes);
+            }
+            // The logger name is copied behind the text, events may outlive their logger
+            const auto &name = context_.logger_name;
+            void *memory = ::operator new(sizeof(seq_log_entry) + property_count * sizeof(span) + text_bytes + name.size());
+            auto *name_copy = static_cast<char *>(memory) + sizeof(seq_log_entry) + property_count * sizeof(span) + text_bytes;
+            std::memcpy(name_copy, name.data(), name.size());
+            auto *entry = new(memory) seq_log_entry(context_.level, {name_copy, name.size()}, property_count, text_bytes);
+            entry->_truncated = dropped > 0;
+
+            auto *spans = entry->spans();
+            auto *text = entry->text();
+            entry->_message_length = entry->copy_limited(text, message_, limits_.max_message_bytes);
+            auto offset = entry->_message_length;
+            for (size_t i = 0; i < count; ++i) {
+                const auto &key = context_[i].first;
+                std::memcpy(text + offset, key.data(), key.size());
+                auto value_length = entry->copy_limited(text + offset + key.size(), context_[i].second.str_val,
+                                                        limits_.max_property_value_bytes);
+                spans[i] = {offset, static_cast<uint32_t>(key.size()), value_length};
+                offset += static_cast<uint32_t>(key.size()) + value_length;
+            }
+            if (dropped > 0) {
+                const auto &key = seq_event_limits::dropped_properties_key;
+                spans[count] = {offset, static_cast<uint32_t>(key.size()), static_cast<uint32_t>(dropped_value.size())};
+                std::memcpy(text + offset, key.data(), key.size());
+                std::memcpy(text + offset + key.size(), dropped_value.data(), dropped_value.size());
+                offset += static_cast<uint32_t>(dropped_bytes);
+                ++count;
+            }
+            if (scope_count > 0) {
+                // Scoped properties are copied as whole blocks: raw keys/values with rebased spans, and the CLEF fragment
+                std::memcpy(text + offset, scope_raw.data(), scope_raw.size());
+                const auto &scope_spans = context_.scope->spans();
+                for (size_t i = 0; i < scope_count; ++i) {
+                    spans[count + i] = {offset + scope_spans[i].key_offset, scope_spans[i].key_length,
+                                        scope_spans[i].value_length};
+                }
+                offset += static_cast<uint32_t>(scope_raw.size());
+                std::memcpy(text + offset, scope_escaped.data(), scope_escaped.size());
+                entry->_scope_count = static_cast<uint32_t>(scope_count);
+                entry->_scope_escaped_offset = offset;
+                entry->_scope_escaped_length = static_cast<uint32_t>(scope_escaped.size());
+            }
+            entry->init_time();
+            return entry;
+        }
 
-        seq_log_entry(std::string message_,
-                      seq_context &&context_)
-                : context(std::move(context_)),
-                  _message(std::move(message_)) {
-            init_time();
+        static void operator delete(void *ptr_) {
+            ::operator delete(ptr_);
+        }
+
+        seq_log_entry(seq_log_entry const &) = delete;
+
+        seq_log_entry &operator=(seq_log_entry const &) = delete;
+
+        ///\brief Append the CLEF line (without trailing newline) for this event to out_
+        void append_raw_json_entry(std::string &out_) const {
+            out_.reserve(out_.size() + 64 + _text_bytes + _property_count * 8);
+            out_ += R"({"@t": ")";
+            append_time(out_);
+            out_ += R"(", "@mt":")";
+            helpers::append_escaped_json(out_, message());
+            out_ += R"(", "@l":")";
+            out_ += logging_level_strings[level];
+            out_ += R"(","Logger":")";
+            out_ += logger_name;
+            out_ += '"';
+            for (size_t i = 0; i < _property_count - _scope_count; ++i) {
+                auto p = property(i);
+                out_ += ",\"";
+                helpers::append_escaped_json(out_, p.key);
+                out_ += "\":\"";
+                helpers::append_escaped_json(out_, p.value);
+                out_ += '"';
+            }
+            out_.append(text() + _scope_escaped_offset, _scope_escaped_length);
+            out_ += '}';
         }
 
         [[nodiscard]] std::string to_raw_json_entry() const {
-            std::stringstream sstream;
-            sstream << R"({"@t": ")" << time << R"(", "@mt":")" << helpers::escape_json(_message) << R"(", "@l":")"
-                    << logging_level_strings[context.level] << R"(","Logger":")" << context.logger_name << "\"";
-            if (context.empty()) {
-                sstream << "}";
-                return sstream.str();
+            std::string json;
+            append_raw_json_entry(json);
+            return json;
+        }
+
+        [[nodiscard]] std::string_view message() const {
+            return {text(), _message_length};
+        }
+
+        ///\brief Append the timestamp as ISO-8601 local time with UTC offset, e.g. 2024-05-01T13:45:12.1234567+02:00
+        void append_time(std::string &out_) const {
+            seq_clock::append_iso8601(out_, timestamp);
+        }
+
+        [[nodiscard]] std::string time() const {
+            std::string result;
+            result.reserve(seq_clock::iso8601_length);
+            append_time(result);
+            return result;
+        }
+
+        [[nodiscard]] size_t property_count() const {
+            return _property_count;
+        }
+
+        ///\brief Whether the message, property values or properties were cut by the limits passed to create()
+        [[nodiscard]] bool truncated() const {
+            return _truncated;
+        }
+
+        ///\brief Size of the single allocation holding the event
+        [[nodiscard]] size_t allocation_bytes() const {
+            return sizeof(seq_log_entry) + _property_count * sizeof(span) + _text_bytes + logger_name.size();
+        }
+
+        [[nodiscard]] seq_property_view property(size_t index_) const {
+            const auto &s = spans()[index_];
+            return {{text() + s.key_offset, s.key_length}, {text() + s.key_offset + s.key_length, s.value_length}};
+        }
+
+        ///\brief Copy the event into a flight recorder slot: spans and text are laid out as its payload format
+        /// expects, so this is a single copy of them
+        void record_to(flight_recorder_writer &recorder_) const noexcept;
+
+        const logging_level level;
+        ///\brief Name of the logger, a copy stored in the event's own allocation
+        const std::string_view logger_name;
+        ///\brief Taken from seq_clock when the event is created, formatted only when the event is written
+        std::chrono::system_clock::time_point timestamp;
+        ///\brief Global, monotonic order in which the event was queued for dispatch
+        uint64_t sequence{0};
+        ///\brief Bytes charged to the memory budget (see seq::set_memory_budget) while the event is queued, 0 if none
+        size_t budget_bytes{0};
+    private:
+        friend struct benchmark_access;
+
+        struct span {
+            uint32_t key_offset;
+            uint32_t key_length;
+            uint32_t value_length;
+        };
+
+        seq_log_entry(logging_level level_, std::string_view logger_name_, size_t property_count_, size_t text_bytes_)
+                : level(level_), logger_name(logger_name_), _property_count(static_cast<uint32_t>(property_count_)),
+                  _text_bytes(static_cast<uint32_t>(text_bytes_)) {}
+
+        [[nodiscard]] span *spans() {
+            return reinterpret_cast<span *>(this + 1);
+        }
+
+        [[nodiscard]] const span *spans() const {
+            return reinterpret_cast<const span *>(this + 1);
+        }
+
+        [[nodiscard]] char *text() {
+            return reinterpret_cast<char *>(spans() + _property_count);
+        }
+
+        [[nodiscard]] const char *text() const {
+            return reinterpret_cast<const char *>(spans() + _property_count);
+        }
+
+        void init_time() {
+            timestamp = seq_clock::now();
+        }
+
+        ///\brief Bytes create() needs for s_ cut to max_bytes_ (0 for unlimited), including the truncation marker
+        static size_t limited_size(std::string_view s_, size_t max_bytes_) {
+            if (max_bytes_ == 0 || s_.size() <= max_bytes_) return s_.size();
+            return helpers::utf8_prefix_length(s_, max_bytes_) + seq_event_limits::truncation_marker.size();
+        }
+
+        ///\brief Copy s_ cut to max_bytes_ to out_, followed by the truncation marker if it was cut
+        ///\return Bytes written, as counted by limited_size()
+        uint32_t copy_limited(char *out_, std::string_view s_, size_t max_bytes_) {
+            if (max_bytes_ == 0 || s_.size() <= max_bytes_) {
+                std::memcpy(out_, s_.data(), s_.size());
+                return static_cast<uint32_t>(s_.size());
             }
-            auto parameters_specified = context.size();
-            for (size_t i = 0; i < parameters_specified; ++i) {
-                sstream << ",\"" << helpers::escape_json(context[i].first) << "\":\"" << helpers::escape_json(context[i].second.str_val) << "\"";
+            auto length = helpers::utf8_prefix_length(s_, max_bytes_);
+            std::memcpy(out_, s_.data(), length);
+            std::memcpy(out_ + length, seq_event_limits::truncation_marker.data(), seq_event_limits::truncation_marker.size());
+            _truncated = true;
+            return static_cast<uint32_t>(length + seq_event_limits::truncation_marker.size());
+        }
+
+        uint32_t _message_length{0};
+        uint32_t _property_count;
+        uint32_t _text_bytes;
+        ///\brief Trailing properties that came from seq_scope, serialized from their pre-escaped fragment
+        uint32_t _scope_count{0};
+        uint32_t _scope_escaped_offset{0};
+        uint32_t _scope_escaped_length{0};
+        bool _truncated{false};
+    };
+
+    ///\brief What happens to an event that does not fit in the memory budget, see seq::set_memory_budget
+    enum class drop_policy {
+        ///\brief Drop the event being logged
+        drop_newest,
+        ///\brief Drop the oldest events still queued by any logger to make room, or the new event if that is not
+        /// enough (e.g. when the budget is held by batches the sinks are still writing)
+        drop_oldest
+    };
+
+    ///\brief Bytes held by queued events, from being queued until the last sink is done with their batch, capped by
+    /// seq::set_memory_budget. Nothing is counted without a budget
+    class seq_memory_budget {
+    public:
+        void configure(size_t max_bytes_, drop_policy policy_) {
+            _policy.store(policy_, std::memory_order_relaxed);
+            _max_bytes.store(max_bytes_, std::memory_order_relaxed);
+        }
+
+        ///\brief Budget in bytes, 0 if there is none
+        [[nodiscard]] size_t max_bytes() const {
+            return _max_bytes.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] drop_policy policy() const {
+            return _policy.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] size_t used_bytes() const {
+            return _used_bytes.load(std::memory_order_relaxed);
+        }
+
+        ///\brief Charge bytes_ if they fit in the budget
+        bool try_charge(size_t bytes_) {
+            auto max = max_bytes();
+            auto used = _used_bytes.load(std::memory_order_relaxed);
+            do {
+                if (used + bytes_ > max) return false;
+            } while (!_used_bytes.compare_exchange_weak(used, used + bytes_, std::memory_order_relaxed));
+            return true;
+        }
+
+        void release(size_t bytes_) {
+            if (bytes_ > 0) _used_bytes.fetch_sub(bytes_, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] static seq_memory_budget &instance() {
+            static seq_memory_budget budget;
+            return budget;
+        }
+
+    private:
+        std::atomic<size_t> _max_bytes{0};
+        std::atomic<drop_policy> _policy{drop_policy::drop_newest};
+        std::atomic<size_t> _used_bytes{0};
+    };
+
+    ///\brief Point-in-time copy of a latency histogram (power-of-two microsecond buckets)
+    struct seq_histogram_snapshot {
+        static constexpr size_t bucket_count = 32;
+
+        ///\brief buckets[i] counts samples in [2^(i-1), 2^i) microseconds, buckets[0] counts samples below 1us
+        uint64_t buckets[bucket_count]{};
+        uint64_t count{0};
+        uint64_t sum_us{0};
+
+        ///\brief Upper bound (in microseconds) of the bucket containing the given percentile, e.g. percentile(0.99)
+        [[nodiscard]] uint64_t percentile(double p_) const {
+            if (count == 0) return 0;
+            auto rank = static_cast<uint64_t>(p_ * static_cast<double>(count));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < bucket_count; ++i) {
+                seen += buckets[i];
+                if (seen > rank) return uint64_t{1} << i;
+            }
+            return uint64_t{1} << (bucket_count - 1);
+        }
+
+        [[nodiscard]] uint64_t mean_us() const {
+            return count == 0 ? 0 : sum_us / count;
+        }
+    };
+
+    ///\brief Snapshot of the logger pipeline metrics, see seq::stats()
+    struct seq_stats {
+        ///\brief Events that passed level filtering, per (final) level
+        uint64_t events_enqueued[6]{};
+        ///\brief Events that were queued for Seq but never delivered (failed request, rejected batch)
+        uint64_t events_dropped{0};
+        ///\brief Events below the MinimumLevelAccepted reported by Seq
+        uint64_t events_filtered{0};
+        ///\brief Events dropped by the drop policy because the memory budget was exhausted
+        uint64_t events_over_budget{0};
+        ///\brief Events cut to the event limits
+        uint64_t events_truncated{0};
+        ///\brief Bytes of queued events charged to the memory budget, 0 without a budget
+        uint64_t budget_bytes_used{0};
+        ///\brief Events waiting in the dispatch queues at the moment of the snapshot
+        uint64_t queue_depth{0};
+        uint64_t bytes_serialized{0};
+        uint64_t bytes_sent{0};
+        uint64_t flushes{0};
+        uint64_t http_requests{0};
+        uint64_t http_failures{0};
+        seq_histogram_snapshot flush_duration;
+        seq_histogram_snapshot http_latency;
+
+        [[nodiscard]] uint64_t total_enqueued() const {
+            uint64_t total = 0;
+            for (auto count: events_enqueued) total += count;
+            return total;
+        }
+    };
+
+    ///\brief Outcome of seq::flush() / seq::shutdown()
+    struct seq_flush_result {
+        ///\brief Events handed to the sinks and not dropped by them
+        uint64_t delivered{0};
+        ///\brief Events dropped meanwhile (failed or timed out requests, discarded sink backlog)
+        uint64_t dropped{0};
+        ///\brief Events still queued when the deadline passed
+        uint64_t pending{0};
+    };
+
+    ///\brief Internal pipeline counters. Hot path counters are sharded per thread to avoid cache line ping-pong,
+    /// dispatcher-side counters are only touched by the dispatcher thread
+    class seq_metrics {
+    public:
+        static constexpr size_t shard_count = 16;
+
+        class histogram {
+        public:
+            void record(std::chrono::microseconds duration_) {
+                auto us = static_cast<uint64_t>(std::max<int64_t>(duration_.count(), 0));
+                size_t bucket = 0;
+                while (bucket + 1 < seq_histogram_snapshot::bucket_count && (uint64_t{1} << bucket) <= us) ++bucket;
+                _buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+                _count.fetch_add(1, std::memory_order_relaxed);
+                _sum_us.fetch_add(us, std::memory_order_relaxed);
             }
-            sstream << "}";
-            auto str = sstream.str();
-            auto cc = str.c_str();
-            return cc;
+
+            [[nodiscard]] seq_histogram_snapshot snapshot() const {
+                seq_histogram_snapshot result;
+                for (size_t i = 0; i < seq_histogram_snapshot::bucket_count; ++i) {
+                    result.buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+                }
+                result.count = _count.load(std::memory_order_relaxed);
+                result.sum_us = _sum_us.load(std::memory_order_relaxed);
+                return result;
+            }
+
+        private:
+            std::atomic<uint64_t> _buckets[seq_histogram_snapshot::bucket_count]{};
+            std::atomic<uint64_t> _count{0};
+            std::atomic<uint64_t> _sum_us{0};
+        };
+
+        void event_enqueued(logging_level level_, bool queued_for_seq_) {
+            auto &s = shard();
+            s.enqueued[level_].fetch_add(1, std::memory_order_relaxed);
+            if (queued_for_seq_) s.queued.fetch_add(1, std::memory_order_relaxed);
         }
 
-        [[nodiscard]] const std::string &message() const {
-            return _message;
+        void event_filtered() {
+            shard().filtered.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void events_dequeued(uint64_t count_) { _dequeued.fetch_add(count_, std::memory_order_relaxed); }
+
+        void events_over_budget(uint64_t count_) { _over_budget.fetch_add(count_, std::memory_order_relaxed); }
+
+        void event_truncated() { _truncated.fetch_add(1, std::memory_order_relaxed); }
+
+        void events_dropped(uint64_t count_) { _dropped.fetch_add(count_, std::memory_order_relaxed); }
+
+        void bytes_serialized(uint64_t count_) { _bytes_serialized.fetch_add(count_, std::memory_order_relaxed); }
+
+        void request_sent(uint64_t bytes_, std::chrono::microseconds latency_, bool failed_) {
+            _http_requests.fetch_add(1, std::memory_order_relaxed);
+            if (failed_) {
+                _http_failures.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                _bytes_sent.fetch_add(bytes_, std::memory_order_relaxed);
+            }
+            _http_latency.record(latency_);
+        }
+
+        void flushed(std::chrono::microseconds duration_) {
+            _flushes.fetch_add(1, std::memory_order_relaxed);
+            _flush_duration.record(duration_);
+        }
+
+        [[nodiscard]] seq_stats snapshot() const {
+            seq_stats result;
+            uint64_t queued = 0;
+            for (const auto &s: _shards) {
+                for (size_t level = 0; level < 6; ++level) {
+                    result.events_enqueued[level] += s.enqueued[level].load(std::memory_order_relaxed);
+                }
+                result.events_filtered += s.filtered.load(std::memory_order_relaxed);
+                queued += s.queued.load(std::memory_order_relaxed);
+            }
+            auto dequeued = _dequeued.load(std::memory_order_relaxed);
+            result.queue_depth = queued > dequeued ? queued - dequeued : 0;
+            result.events_dropped = _dropped.load(std::memory_order_relaxed);
+            result.events_over_budget = _over_budget.load(std::memory_order_relaxed);
+            result.events_truncated = _truncated.load(std::memory_order_relaxed);
+            result.budget_bytes_used = seq_memory_budget::instance().used_bytes();
+            result.bytes_serialized = _bytes_serialized.load(std::memory_order_relaxed);
+            result.bytes_sent = _bytes_sent.load(std::memory_order_relaxed);
+            result.flushes = _flushes.load(std::memory_order_relaxed);
+            result.http_requests = _http_requests.load(std::memory_order_relaxed);
+            result.http_failures = _http_failures.load(std::memory_order_relaxed);
+            result.flush_duration = _flush_duration.snapshot();
+            result.http_latency = _http_latency.snapshot();
+            return result;
+        }
+
+        [[nodiscard]] static seq_metrics &instance() {
+            static seq_metrics metrics;
+            return metrics;
         }
 
-        const seq_context context;
-        char time[24];
     private:
-        void init_time() {
-            auto str = std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
-                    std::chrono::system_clock::now().time_since_epoch()).count() % 1000);
-            time_t rawtime;
-            struct tm *timeinfo;
-            std::time(&rawtime);
-            timeinfo = localtime(&rawtime);
-            strftime(time, 23, "%FT%T.", timeinfo);
-            time[19] = '.';
-            std::copy(&str[0], &str[3], &time[20]);
-            time[23] = '\0';
-        }
-
-        std::string _message;
+        struct alignas(64) shard_t {
+            std::atomic<uint64_t> enqueued[6]{};
+            std::atomic<uint64_t> queued{0};
+            std::atomic<uint64_t> filtered{0};
+        };
+
+        shard_t &shard() {
+            static std::atomic<size_t> next_shard{0};
+            thread_local size_t index = next_shard.fetch_add(1, std::memory_order_relaxed) % shard_count;
+            return _shards[index];
+        }
+
+        shard_t _shards[shard_count];
+        std::atomic<uint64_t> _dequeued{0};
+        std::atomic<uint64_t> _dropped{0};
+        std::atomic<uint64_t> _over_budget{0};
+        std::atomic<uint64_t> _truncated{0};
+        std::atomic<uint64_t> _bytes_serialized{0};
+        std::atomic<uint64_t> _bytes_sent{0};
+        std::atomic<uint64_t> _flushes{0};
+        std::atomic<uint64_t> _http_requests{0};
+        std::atomic<uint64_t> _http_failures{0};
+        histogram _flush_duration;
+        histogram _http_latency;
+    };
+
+    ///\brief Entries taken from the dispatch queues in one dispatch cycle, shared by all sinks.
+    /// Entries are freed together with the batch, once the last sink is done with it, which is also when their
+    /// memory budget is released
+    class seq_log_batch {
+    public:
+        explicit seq_log_batch(std::vector<seq_log_entry *> &&entries_, bool priority_ = false)
+                : entries(std::move(entries_)), priority(priority_) {}
+
+        ~seq_log_batch() {
+            size_t budget_bytes = 0;
+            for (auto *entry: entries) {
+                budget_bytes += entry->budget_bytes;
+                delete entry;
+            }
+            seq_memory_budget::instance().release(budget_bytes);
+        }
+
+        seq_log_batch(seq_log_batch const &) = delete;
+
+        seq_log_batch &operator=(seq_log_batch const &) = delete;
+
+        const std::vector<seq_log_entry *> entries;
+        ///\brief Whether the batch holds events of the priority lane (see seq::priority_level)
+        const bool priority;
+    };
+
+    typedef std::shared_ptr<const seq_log_batch> seq_log_batch_ptr;
+
+    ///\brief How a sink is driven, see seq::add_sink
+    enum class sink_mode {
+        ///\brief On the logging thread, as part of the logging call (gated by seq::level_console)
+        synchronous,
+        ///\brief On the dispatcher thread, once per dispatch interval (gated by seq::level_seq)
+        dispatcher,
+        ///\brief On a dedicated drain thread fed by the dispatcher, so a slow sink does not delay the others
+        own_thread
+    };
+
+    ///\brief Output for log events. A sink is only ever called from one thread at a time, so implementations do not
+    /// need to be thread safe
+    class seq_sink {
+    public:
+        explicit seq_sink(logging_level level_ = logging_level::verbose) : level(level_) {}
+
+        virtual ~seq_sink() = default;
+
+        ///\brief Minimum level of events written by this sink
+        std::atomic<logging_level> level;
+
+        ///\brief Minimum level currently accepted, events below it are not handed to the sink
+        [[nodiscard]] virtual logging_level effective_level() const {
+            return level.load(std::memory_order_relaxed);
+        }
+
+        ///\brief Called before the writes of a batch with the number of events that are going to be written
+        virtual void begin_batch([[maybe_unused]] size_t events_) {}
+
+        virtual void write(const seq_log_entry &entry_) = 0;
+
+        ///\brief Called after the last write of a batch, buffering sinks flush here
+        virtual void end_batch() {}
+
+        ///\brief Write all events of the batch at or above effective_level()
+        void write_batch(const std::vector<seq_log_entry *> &entries_) {
+            auto min_level = effective_level();
+            size_t events = 0;
+            for (const auto *entry: entries_) {
+                if (entry->level >= min_level) ++events;
+            }
+            if (events == 0) return;
+            try {
+                begin_batch(events);
+                for (const auto *entry: entries_) {
+                    if (entry->level >= min_level) write(*entry);
+                }
+                end_batch();
+            } catch (const std::exception &e) {
+                report_error(e);
+            }
+        }
+
+        ///\brief Report an exception thrown while writing to a sink (to stderr, at most once per second with the number
+        /// of errors left out meanwhile)
+        static void report_error(const std::exception &e_);
+    };
+
+    ///\brief Colored console output, errors and fatals go to stderr
+    class console_sink : public seq_sink {
+    public:
+        explicit console_sink(logging_level level_ = logging_level::verbose) : seq_sink(level_) {}
+
+        void write(const seq_log_entry &entry_) override;
+    };
+
+    ///\brief How seq_http_sink spreads batches over several Seq nodes
+    enum class endpoint_selection {
+        ///\brief Spread batches over the healthy nodes in turn. Batches large enough (see
+        /// seq_http_sink::split_min_events) are split into contiguous sequence ranges posted to the nodes in parallel,
+        /// so ingestion throughput grows with the number of nodes
+        round_robin,
+        ///\brief Post the whole batch to the healthy node with the lowest recent request latency
+        least_latency
+    };
+
+    enum class file_write_backend;
+
+    class clef_file_sink;
+
+    class binary_file_sink;
+
+    class seq_http_sink;
+
+    class seq_sink_worker;
+
+    class config_file_watcher;
+
+    ///\brief Placement and scheduling of the threads started by the logger (the dispatcher and the drain threads of
+    /// sink_mode::own_thread sinks), see seq::set_thread_options. Applied by each thread to itself when it starts,
+    /// before it allocates its buffers, so that with the default first-touch NUMA policy those end up on the node of
+    /// the CPUs it is pinned to
+    struct seq_thread_options {
+        ///\brief CPUs the threads may run on (Linux), empty keeps the inherited affinity
+        std::vector<int> cpus;
+        ///\brief Whether to apply nice (Linux, per thread)
+        bool set_nice{false};
+        ///\brief Nice level, -20 (highest priority) to 19 (lowest)
+        int nice{0};
+        ///\brief Scheduling policy, e.g. SCHED_BATCH, SCHED_IDLE or SCHED_FIFO, -1 keeps the inherited one
+        int policy{-1};
+        ///\brief Static priority for SCHED_FIFO / SCHED_RR, must be 0 for the other policies
+        int priority{0};
+        ///\brief Prefix of the thread names shown in top, ps or perf, e.g. "seq-dispatch", "seq-sink1"
+        std::string name_prefix{"seq"};
     };
 
-    class seq {
+    ///\brief Whether the calling thread works for the logger: the dispatcher, the drain threads of own-thread sinks, or
+    /// a thread dispatching events in seq::flush(). What these threads log (e.g. sink errors) must not wake the
+    /// dispatcher again, or a failing sink would keep it busy
+    inline bool &in_logger_thread() {
+        thread_local bool logger_thread{false};
+        return logger_thread;
+    }
+
+    class seq_child_logger;
+
+    class seq : public std::enable_shared_from_this<seq> {
     public:
         ///\brief Base console logging level for all loggers - when other loggers are created, that level is used as a base
-        inline static logging_level base_level_console;
+        inline static std::atomic<logging_level> base_level_console;
 
         ///\brief Base seq logging level for all loggers - when other loggers are created, that level is used as a base
-        inline static logging_level base_level_seq;
+        inline static std::atomic<logging_level> base_level_seq;
 
-        ///\brief Console logging level for this logger
-        logging_level level_console = logging_level::debug;
+        ///\brief Console logging level for this logger, can be changed at any time (see also watch_level_config)
+        std::atomic<logging_level> level_console{logging_level::debug};
 
-        ///\brief Seq logging level for this logger
-        logging_level level_seq = logging_level::verbose;
+        ///\brief Seq logging level for this logger, can be changed at any time (see also watch_level_config)
+        std::atomic<logging_level> level_seq{logging_level::verbose};
+
+        ///\brief Events at or above this level take the priority lane: they wake the dispatcher right away instead of
+        /// waiting for the dispatch interval, are handed to the sinks ahead of other events, and are exempt from the
+        /// memory budget and the drop policies of own-thread sinks
+        inline static std::atomic<logging_level> priority_level{logging_level::error};
+
+        ///\brief Time the final flush at process exit may take at most, see shutdown()
+        inline static std::chrono::milliseconds exit_timeout{5000};
+
+        ///\brief Minimum level Seq reported as accepted in its last ingestion response (MinimumLevelAccepted).
+        /// Events below it are dropped before being queued, regardless of level_seq of the logger
+        [[nodiscard]] static logging_level server_level_seq() {
+            return _s_server_level_seq.load(std::memory_order_relaxed);
+        }
 
 
         ///\brief Default constructor
         seq() {
-            finish_initialization({});
+            finish_initialization({}, base_level_console, base_level_seq);
         }
 
         ///\brief Constructor with properties
         ///\param properties_ Properties to be added to the logger
         seq(const char *name_, seq_properties_vector_t &&properties_) : _properties(std::move(properties_)) {
-            finish_initialization(name_);
+            finish_initialization(name_, base_level_console, base_level_seq);
         }
 
         ///\brief Constructor with properties
         ///\param properties_ Properties to be added to the logger
         seq(const char *name_, seq_properties_pair_t &&property_pair_) : _properties({std::move(property_pair_)}) {
-            finish_initialization(name_);
+            finish_initialization(name_, base_level_console, base_level_seq);
         }
 
         ///\brief Constructor with name
         ///\param name_ Name of the logger
         explicit seq(const char *name_) {
-            finish_initialization(name_);
+            finish_initialization(name_, base_level_console, base_level_seq);
         }
 
         ///\brief Constructor with name and logging levels
@@ -287,9 +1103,7 @@ namespace seq_logger {
         /// \param console_verbosity_ Logging level for the console, e.g. logging_level::info would output info, but not debug messages
         /// \param seq_verbosity_ Logging level for SEQ, e.g. logging_level::info would output info, but not debug messages
         explicit seq(const char *name_, logging_level console_verbosity_, logging_level seq_verbosity_) {
-            finish_initialization(name_);
-            level_console = console_verbosity_;
-            level_seq = seq_verbosity_;
+            finish_initialization(name_, console_verbosity_, seq_verbosity_);
         }
 
 
@@ -297,24 +1111,16 @@ namespace seq_logger {
             _enrichers.clear();
 
             if (!_static_instance) {
-                std::lock_guard<std::mutex> guard(_logs_mutex);
+                // Unregister before taking own lock: the dispatcher locks loggers list first, then each logger
                 unregister_logger(this);
-                shared_instance().transfer_logs(_seq_dispatch_queue);
+                std::lock_guard<std::mutex> guard(_logs_mutex);
+                shared_instance().transfer_logs(_seq_dispatch_queue, false);
+                shared_instance().transfer_logs(_seq_priority_queue, true);
                 return;
             }
 
-            {
-                std::unique_lock<std::mutex> lock{_s_thread_finished_mutex};
-                _s_terminating = true;
-            }
-
-            std::unique_lock<std::mutex> lock{_s_thread_finished_mutex};
-            _s_thread_finished.wait(lock);
-            if (_s_thread.joinable()) {
-                _s_thread.join();
-            }
-            http::Request request("http://" + _s_address + "/api/events/raw?clef");
-            send_events_handler(request);
+            if (!_s_initialized) return;
+            shutdown(std::chrono::steady_clock::now() + exit_timeout);
         }
 
         seq(seq const &) = delete;
@@ -326,17 +1132,37 @@ namespace seq_logger {
         seq &operator=(seq &&) = delete;
 
         /// \brief Initialize the Seq logger
-        /// \param address_ Address of the Seq server, e.g. 127.0.0.1:5341
+        /// \param address_ Address of the Seq server, e.g. 127.0.0.1:5341. Empty address disables shipping to Seq
+        /// (e.g. when only file outputs are used)
         /// \param console_verbosity_ Logging level for the console, e.g. logging_level::info would output info, but not debug messages
         /// \param seq_verbosity_ Logging level for SEQ, e.g. logging_level::info would output info, but not debug messages
         /// \param dispatch_interval_ Interval at which to send logs to SEQ, in milliseconds
         /// \param api_key_ Seq API key
         /// \param seq_init_timeout Timeout for SEQ initialization, in milliseconds. If SEQ is not available after this time, the logger will start without SEQ if allow_without_seq is true
         /// \param allow_without_seq If SEQ is not available, allow the logger to start without SEQ
+        /// \note Returns right away, the Seq health check runs on the dispatcher thread and events are kept queued
+        /// until it completed, see wait_ready()
         static void init(std::string address_, logging_level console_verbosity_, logging_level seq_verbosity_,
                          size_t dispatch_interval_, const std::string &api_key_ = "", int seq_init_timeout = 1000, bool allow_without_seq = true) {
+            std::vector<std::string> addresses;
+            if (!address_.empty()) addresses.push_back(std::move(address_));
+            init(std::move(addresses), console_verbosity_, seq_verbosity_, dispatch_interval_, api_key_, seq_init_timeout,
+                 allow_without_seq);
+        }
+
+        /// \brief Initialize the Seq logger with several Seq nodes (e.g. a cluster), batches are spread over the nodes
+        /// passing /health and fail over to the others when a node stops responding
+        /// \param addresses_ Addresses of the Seq nodes, e.g. {"10.0.0.1:5341", "10.0.0.2:5341"}. Empty list disables shipping to Seq
+        /// \param selection_ Send batches to the healthy nodes in turn, or to the one with the lowest latency
+        /// \see init(std::string, logging_level, logging_level, size_t, const std::string &, int, bool)
+        static void init(std::vector<std::string> addresses_, logging_level console_verbosity_, logging_level seq_verbosity_,
+                         size_t dispatch_interval_, const std::string &api_key_ = "", int seq_init_timeout = 1000,
+                         bool allow_without_seq = true, endpoint_selection selection_ = endpoint_selection::round_robin) {
             if (_s_initialized) return;
-            _s_address = std::move(address_);
+            // Construct the shared instance first: its constructor resets the static configuration
+            auto &instance = shared_instance();
+            _s_addresses = std::move(addresses_);
+            _s_endpoint_selection = selection_;
             if (!api_key_.empty()) {
                 _s_auth_header = api_key_;
             }
@@ -344,7 +1170,129 @@ namespace seq_logger {
             base_level_console = console_verbosity_;
             base_level_seq = seq_verbosity_;
             _s_dispatch_interval = std::chrono::milliseconds(dispatch_interval_);
-            shared_instance().start_thread(seq_init_timeout, allow_without_seq);
+            instance.start_thread(seq_init_timeout, allow_without_seq);
+        }
+
+        /// \brief Wait until the dispatcher completed its startup (the Seq health check of init())
+        /// \return Whether Seq is available (or none is configured), false if it is not or on timeout
+        static bool wait_ready(std::chrono::milliseconds timeout_) {
+            std::unique_lock<std::mutex> lock{_s_ready_mutex};
+            _s_ready_changed.wait_for(lock, timeout_, [] { return _s_startup_finished; });
+            return _s_startup_finished && _s_seq_available;
+        }
+
+        /// \brief Dispatch everything logged so far and wait until the sinks wrote it, or until deadline_. HTTP requests
+        /// are cut short at the deadline, their events count as dropped
+        static seq_flush_result flush(std::chrono::steady_clock::time_point deadline_);
+
+        static seq_flush_result flush(std::chrono::milliseconds timeout_) {
+            return flush(std::chrono::steady_clock::now() + timeout_);
+        }
+
+        /// \brief flush() on a separate thread, the deadline is counted from now
+        static std::future<seq_flush_result> flush_async(std::chrono::milliseconds timeout_);
+
+        /// \brief Stop the dispatcher thread, flush and stop the drain threads of own-thread sinks, all within deadline_
+        /// (unless a custom sink blocks). Events logged afterwards only reach synchronous sinks (the console) until
+        /// the final flush at exit, which calls this with exit_timeout
+        static seq_flush_result shutdown(std::chrono::steady_clock::time_point deadline_);
+
+        static seq_flush_result shutdown(std::chrono::milliseconds timeout_) {
+            return shutdown(std::chrono::steady_clock::now() + timeout_);
+        }
+
+        /// \brief Add an output for log events
+        /// \param sink_ Sink, its level is applied on top of the level_console / level_seq of loggers
+        /// \param mode_ Whether the sink is written on the logging thread (synchronous, gated by level_console), on the
+        /// dispatcher thread or on its own drain thread (both gated by level_seq)
+        /// \param max_pending_batches_ For sink_mode::own_thread, batches kept while the sink is busy before the oldest are dropped
+
+        static void add_sink(std::shared_ptr<seq_sink> sink_, sink_mode mode_ = sink_mode::dispatcher,
+                             size_t max_pending_batches_ = 64);
+
+        /// \brief Remove a previously added sink (including default_console_sink()), its drain thread if any is
+        /// stopped after writing what is still pending
+
+        static void remove_sink(const std::shared_ptr<seq_sink> &sink_);
+
+        /// \brief Console sink registered (synchronously) by default
+        [[nodiscard]] static const std::shared_ptr<console_sink> &default_console_sink() {
+            static auto sink = std::make_shared<console_sink>();
+            return sink;
+        }
+
+        /// \brief Also write every dispatched event into compact binary segment files (see seq_binary.hpp),
+        /// which can be turned into CLEF later with seq_binary_decoder. Useful on hosts without reliable access to Seq
+        /// \param directory_ Existing directory to write segments to
+        /// \param prefix_ Segment file name prefix
+        /// \param max_segment_bytes_ Segment size after which a new segment file is started
+        static std::shared_ptr<binary_file_sink> enable_binary_file_output(std::string directory_, std::string prefix_ = "seq",
+                                                                           size_t max_segment_bytes_ = 64 * 1024 * 1024);
+
+        /// \brief Also append every dispatched event to a newline-delimited CLEF file (same lines as sent to Seq),
+        /// written by the dispatcher thread through a large buffer so callers never touch the disk
+        /// \param path_ Path of the active file, e.g. /var/log/my_service.clef
+        /// \param max_file_bytes_ Size after which the file is rotated, 0 disables size based rotation
+        /// \param max_file_age_ Age after which the file is rotated, zero disables time based rotation
+        /// \param compress_rotated_ Gzip rotated files in the background
+        /// \param backend_ file_write_backend::io_uring submits the writes of all files of a dispatch with one syscall,
+        /// the default is file_write_backend::blocking
+        static std::shared_ptr<clef_file_sink> enable_clef_file_output(std::string path_, size_t max_file_bytes_ = 128 * 1024 * 1024,
+                                                                       std::chrono::seconds max_file_age_ = std::chrono::hours(24),
+                                                                       bool compress_rotated_ = false,
+                                                                       file_write_backend backend_ = file_write_backend());
+
+        /// \brief Source of event timestamps. clock_source::tsc reads the CPU timestamp counter instead of calling
+        /// system_clock on every event, and is kept aligned with system_clock by the dispatcher thread
+        /// \return false if the source is unavailable on this machine (the system clock is kept)
+        static bool set_clock_source(clock_source source_) {
+            return seq_clock::use(source_);
+        }
+
+        /// \brief CPU affinity, scheduling and names of the threads the logger starts (the dispatcher and the drain
+        /// threads of sink_mode::own_thread sinks), e.g. to keep them off the CPUs of latency critical workers.
+        /// Applies to threads started afterwards, so call it before init() and add_sink()
+        static void set_thread_options(seq_thread_options options_) {
+            std::lock_guard<std::mutex> guard(_s_sinks_mutex);
+            _s_thread_options = std::move(options_);
+        }
+
+        /// \brief Cap the memory held by queued events (from being logged until all sinks wrote them), e.g. while Seq is
+        /// unreachable. Events that do not fit are handled according to policy_ and counted in
+        /// seq_stats::events_over_budget. Applies to events queued afterwards
+        /// \param max_bytes_ Budget in bytes, 0 removes it
+        static void set_memory_budget(size_t max_bytes_, drop_policy policy_ = drop_policy::drop_newest) {
+            seq_memory_budget::instance().configure(max_bytes_, policy_);
+        }
+
+        /// \brief Size limits applied to every event as it is logged, before it reaches any sink (see seq_event_limits),
+        /// so a single huge message or property cannot take up the memory budget
+        static void set_event_limits(const seq_event_limits &limits_) {
+            _s_max_message_bytes.store(limits_.max_message_bytes, std::memory_order_relaxed);
+            _s_max_properties.store(limits_.max_properties, std::memory_order_relaxed);
+            _s_max_property_value_bytes.store(limits_.max_property_value_bytes, std::memory_order_relaxed);
+        }
+
+        /// \brief Snapshot of the logger pipeline metrics (events per level, drops, queue depth, bytes, flush and HTTP timings)
+        [[nodiscard]] static seq_stats stats() {
+            return metrics().snapshot();
+        }
+
+        /// \brief Also copy every event into a crash-surviving, memory-mapped ring file as it is logged (before it is
+        /// queued), see flight_recorder_writer. seq_flight_recorder_dump extracts the last events from it after a crash.
+        /// Only the first call has an effect, the file stays mapped until the process exits
+        /// \param path_ File to map, a previous recording is kept as <path_>.prev
+        /// \param slot_count_ Number of events kept
+        /// \param slot_bytes_ Size of an event slot, larger events are truncated
+        static void enable_flight_recorder(std::string path_, size_t slot_count_ = 16384, size_t slot_bytes_ = 1024);
+
+        /// \brief Record an event in the flight recorder only (if enabled). Async-signal safe, e.g. for crash handlers
+        static void flight_record(logging_level level_, std::string_view message_) noexcept;
+
+        /// \brief Periodically ship a snapshot of stats() to Seq as a "Logger statistics" event
+        /// \param interval_ Interval between two events, zero disables self-monitoring events
+        static void enable_self_monitoring(std::chrono::milliseconds interval_) {
+            _s_self_monitoring_interval_ms.store(interval_.count(), std::memory_order_relaxed);
         }
 
         /// \brief Add a property to all logs
@@ -369,6 +1317,38 @@ namespace seq_logger {
             _s_enrichers.push_back(std::move(enricher_));
         }
 
+        /// \brief Logger registered under name_ (e.g. "Component.Sub"), created on first lookup with the levels of the
+        /// most specific set_levels() rule for that name. The handle can be kept and shared between call sites. Loggers
+        /// stay registered until release(), so names should come from a bounded set
+        [[nodiscard]] static std::shared_ptr<seq> get(std::string_view name_);
+
+        /// \brief Remove the logger named name_ from the registry of get(), it is destroyed with the last handle to it
+        /// (events it queued are still dispatched). A later get() creates a new logger
+        /// \return Whether a logger was registered under name_
+        static bool release(std::string_view name_);
+
+        /// \brief Levels of loggers obtained with get() named name_ or below it, e.g. "Component" applies to
+        /// "Component" and "Component.Sub"; the most specific rule wins. Applied when a logger is first looked up
+        static void set_levels(std::string name_, logging_level console_verbosity_, logging_level seq_verbosity_) {
+            std::lock_guard<std::mutex> guard(_s_level_rules_mutex);
+            _s_level_rules[std::move(name_)] = {console_verbosity_, seq_verbosity_};
+        }
+
+        /// \brief Take levels from a config file of glob rules, e.g. "Billing.* = debug" or "*.Http = warn, info" (see
+        /// parse_level_rules), re-read by a thread of its own as soon as the file changes, also before init(). Rules are
+        /// matched against logger names in order and the last matching one wins; they override levels set in code,
+        /// set_levels() and the SEQ_LOGGER_LEVELS environment variable (same format). Loggers no longer matched get
+        /// their levels back
+        static void watch_level_config(std::string path_);
+
+        /// \brief Replace the config rules (see watch_level_config) with rules_, stops watching a config file
+        static void set_level_config(std::string_view rules_);
+
+        /// \brief Lightweight logger adding properties to the logs of this one (e.g. per request), without registering
+        /// a logger of its own. It shares this logger's name, levels, properties, enrichers and queue: a logger owned by
+        /// a std::shared_ptr (e.g. from get()) is kept alive by its children, any other one must outlive them
+        [[nodiscard]] seq_child_logger child(seq_properties_vector_t &&properties_) const;
+
 //region instance logging method implementations
         void verbose(std::string message_, seq_properties_vector_t &&properties_) const {
             instance_log_generic<logging_level::verbose>(std::move(message_), std::move(properties_));
@@ -471,31 +1451,90 @@ namespace seq_logger {
         }
 //endregion
     private:
+        friend struct benchmark_access;
+        friend struct test_access;
+        friend class seq_http_sink;
+        friend class seq_child_logger;
+
         inline static bool _s_initialized;
         inline static bool _s_terminating;
-        inline static std::string _s_address;
+        inline static std::vector<std::string> _s_addresses;
+        inline static endpoint_selection _s_endpoint_selection{endpoint_selection::round_robin};
         inline static std::string _s_auth_header;
         inline static std::chrono::duration<long long, std::milli> _s_dispatch_interval;
         inline static std::mutex _s_thread_finished_mutex;
-        inline static std::mutex _s_thread_started_mutex;
+        inline static std::mutex _s_ready_mutex;
         inline static std::condition_variable _s_thread_finished;
-        inline static std::condition_variable _s_thread_started;
+        ///\brief Wakes the dispatcher thread before the end of its interval, e.g. to terminate
+        inline static std::condition_variable _s_dispatcher_wake;
+        ///\brief Whether events were queued in the priority lane since it was last dispatched
+        inline static std::atomic_bool _s_priority_pending{false};
+        inline static bool _s_thread_running{false};
+        inline static bool _s_thread_exited{false};
+        ///\brief Serializes dispatching between the dispatcher thread and flush()
+        inline static std::timed_mutex _s_dispatch_mutex;
+        ///\brief Deadline (steady_clock, ns since epoch) of the flush in progress, 0 if none
+        inline static std::atomic<int64_t> _s_flush_deadline_ns{0};
+        inline static std::condition_variable _s_ready_changed;
+        ///\brief Whether the dispatcher finished its startup (Seq health check), and whether Seq is available then
+        inline static bool _s_startup_finished{false};
+        inline static bool _s_seq_available{false};
         inline static std::mutex _s_loggers_mutex;
         inline static std::vector<seq *> _s_loggers;
         inline static std::atomic_int32_t _s_logger_id{0};
         inline static seq_properties_vector_t _s_shared_properties;
         inline static std::vector<std::function<void(seq_context &)>> _s_enrichers;
+        inline static std::atomic<logging_level> _s_server_level_seq{logging_level::verbose};
+        inline static std::atomic<int64_t> _s_self_monitoring_interval_ms{0};
+        inline static std::atomic<logging_level> _s_dispatch_floor{logging_level::verbose};
+        inline static std::atomic<uint64_t> _s_sequence{0};
+        inline static std::mutex _s_sinks_mutex;
+        inline static std::atomic<flight_recorder_writer *> _s_flight_recorder{nullptr};
+        ///\brief Guarded by _s_sinks_mutex
+        inline static seq_thread_options _s_thread_options;
+        ///\brief See set_event_limits
+        inline static std::atomic<size_t> _s_max_message_bytes{0};
+        inline static std::atomic<size_t> _s_max_properties{0};
+        inline static std::atomic<size_t> _s_max_property_value_bytes{0};
+
+        struct sink_slot {
+            std::shared_ptr<seq_sink> sink;
+            sink_mode mode;
+            ///\brief Serializes synchronous writes coming from different logging threads
+            std::shared_ptr<std::mutex> mutex;
+            std::shared_ptr<seq_sink_worker> worker;
+        };
+
+        typedef std::vector<sink_slot> sinks_t;
 
         mutable std::vector<seq_log_entry *> _seq_dispatch_queue;
+        ///\brief Events at or above priority_level, see there
+        mutable std::vector<seq_log_entry *> _seq_priority_queue;
         mutable std::mutex _logs_mutex;
 
         bool _static_instance{false};
-        char _name[32]{"Default\0"};
+        std::string _name{"Default"};
+
+        inline static std::mutex _s_level_rules_mutex;
+        inline static std::unordered_map<std::string, std::pair<logging_level, logging_level>> _s_level_rules;
+
+        ///\brief Guards the config rules, the watcher and the pre-config levels of all loggers; taken before _s_loggers_mutex
+        inline static std::mutex _s_level_config_mutex;
+        inline static bool _s_env_level_rules_loaded{false};
+        inline static std::vector<seq_level_rule> _s_env_level_rules;
+        inline static std::vector<seq_level_rule> _s_config_level_rules;
+
+        ///\brief Whether the levels of this logger come from a config rule, and its levels from before that
+        std::atomic_bool _levels_from_config{false};
+        logging_level _level_console_before_config{logging_level::verbose};
+        logging_level _level_seq_before_config{logging_level::verbose};
+
+        ///\brief Part of the registry of get(), defined in seq_impl.hpp
+        struct registry_shard;
 
         seq_properties_vector_t _properties;
         std::vector<std::function<void(seq_context &)>> _enrichers;
         const int32_t id = _s_logger_id++;
-        std::thread _s_thread;
         seq(bool) {
             _s_initialized = false;
             _s_terminating = false;
@@ -506,123 +1545,102 @@ namespace seq_logger {
             register_logger(this);
         }
 
-        static void send_events_handler(http::Request &request_) {
-            bool hasData(false);
-            std::stringstream sstream;
-            {
-                std::lock_guard<std::mutex> static_guard(_s_loggers_mutex);
-                if (_s_loggers.empty()) return;
-                int32_t index = _s_loggers.size() - 1;
-                while (index >= 0) {
-                    auto &logger = _s_loggers[index];
-                    std::lock_guard<std::mutex> guard(logger->_logs_mutex);
-
-                    while (!logger->_seq_dispatch_queue.empty()) {
-                        hasData = true;
-                        sstream << logger->_seq_dispatch_queue.back()->to_raw_json_entry() << "\n";
-                        delete logger->_seq_dispatch_queue.back();
-                        logger->_seq_dispatch_queue.pop_back();
-                    }
+        /// \brief Hand everything queued so far to the dispatcher and own-thread sinks, the priority lane first
+        /// \param priority_only_ Dispatch the priority lane only, e.g. when woken by a priority event
+        /// \return Number of events dispatched. Requires _s_dispatch_mutex
+        static size_t dispatch_events(bool priority_only_ = false);
 
-                    --index;
-                }
-            }
-            if (hasData) {
-                try {
-                    http::Response resp;
-                    if (_s_auth_header.empty()) {
-                        resp = request_.send("POST", sstream.str(), {{
-                                                                             "Content-type", "application/json"
-                                                                     }});
-                    } else {
-                        resp = request_.send("POST", sstream.str(), {
-                                {"Content-type", "application/json" },
-                                {"X-Seq-ApiKey", _s_auth_header}
-                        });
-                    }
-                    if (resp.status.code > 300) {
-                        std::string body(resp.body.begin(), resp.body.end());
-                        std::cout << "Error while sending batch " << resp.status.code << ":" << resp.status.reason << "\n" << body << std::endl;
-                    }
-                } catch (const std::exception &e) {
-                    log_error("Error while trying to ingest logs:", {{"What", e.what()}});
-                }
-            }
+        /// \brief Take the queues of all loggers (their priority lanes if priority_), merged in sequence order
+        static std::vector<seq_log_entry *> take_queued(bool priority_);
+
+        /// \brief K-way merge of logger queues (each already in sequence order) into a single sequence ordered batch
+        static std::vector<seq_log_entry *> merge_by_sequence(std::vector<std::vector<seq_log_entry *>> &queues_);
+
+        /// \brief Stop drain threads of own-thread sinks, after they wrote what is pending
+        /// \return Number of events dropped because the deadline passed
+        static uint64_t stop_sink_workers(std::chrono::steady_clock::time_point deadline_);
+
+        [[nodiscard]] static std::shared_ptr<const sinks_t> &sinks_storage() {
+            static std::shared_ptr<const sinks_t> storage = std::make_shared<const sinks_t>(sinks_t{
+                    {default_console_sink(), sink_mode::synchronous, std::make_shared<std::mutex>(), nullptr}
+            });
+            return storage;
         }
 
-        static void send_events_loop_handler(int timeout, bool allow_without_seq) {
-            bool seq_ready(false);
-            try {
-                http::Request health_check_request("http://" + _s_address + "/health");
-
-                auto response = health_check_request.send("GET", "", {}, std::chrono::milliseconds(timeout));
-                if (response.status.code == 200 ||
-                    std::string{response.body.begin(), response.body.end()}.find("The Seq node is in service.") !=
-                    std::string::npos) {
-                    seq_ready = true;
-                } else {
-                    log_warning("Seq ingestion not ready");
-                }
-            } catch (const std::exception &e) {
-                log_error("Error while checking Seq status", {{"What", e.what()}});
-            }
+        [[nodiscard]] static std::shared_ptr<const sinks_t> current_sinks() {
+            return std::atomic_load(&sinks_storage());
+        }
 
-            if (!seq_ready) {
-                if (allow_without_seq){
-                    log_info("Seq failed to initialize, but working without it is allowed. Only using console output.");
-                } else {
-                    std::unique_lock<std::mutex> lock{_s_thread_finished_mutex};
-                    _s_terminating = true;
-                    _s_thread_finished.notify_all();
-                    return;
-                }
+        /// \brief Recompute the lowest level any dispatched sink accepts, so that events no sink wants are not even queued
+        static void update_dispatch_floor() {
+            auto sinks = current_sinks();
+            bool any(false);
+            auto floor = logging_level::fatal;
+            for (const auto &slot: *sinks) {
+                if (slot.mode == sink_mode::synchronous) continue;
+                any = true;
+                floor = std::min(floor, slot.sink->effective_level());
             }
+            // Without dispatched sinks (e.g. before init) keep everything queued until there are some
+            _s_dispatch_floor.store(any ? floor : logging_level::verbose, std::memory_order_relaxed);
+        }
 
-            http::Request request("http://" + _s_address + "/api/events/raw?clef");
+        /// \brief Write a "Logger statistics" event straight to seq_sink_ if self-monitoring is due. It bypasses the queues,
+        /// so it never reaches the console or file outputs. Requires _s_dispatch_mutex
+        static void emit_self_monitoring_event(std::chrono::steady_clock::time_point &last_emitted_, seq_sink &seq_sink_);
 
-            {
-                std::unique_lock<std::mutex> lock_start{_s_thread_started_mutex};
-                _s_thread_started.notify_all();
-            }
+        /// \brief Adjust the seq level floor from the MinimumLevelAccepted value of an ingestion response body,
+        /// e.g. {"MinimumLevelAccepted":"Warning"}; null (or no value) means everything is accepted
+        static void update_server_level_seq(std::string_view body_);
 
-            while (!_s_terminating) {
-                std::this_thread::sleep_for(_s_dispatch_interval);
-                send_events_handler(request);
-            }
+        static void send_events_loop_handler(int timeout, bool allow_without_seq);
 
-            std::unique_lock<std::mutex> lock{_s_thread_finished_mutex};
-            _s_thread_finished.notify_all();
+        [[nodiscard]] logging_level effective_level_seq() const {
+            return std::max(level_seq.load(std::memory_order_relaxed), _s_dispatch_floor.load(std::memory_order_relaxed));
         }
 
         template<logging_level L>
         void instance_log_generic(std::string message_, seq_properties_vector_t &&properties_) const {
-            if (L < level_console && L < level_seq) return;
+            if (L < level_console.load(std::memory_order_relaxed) && L < effective_level_seq()) return;
             enqueue(std::move(message_), make_context(L, properties_));
         }
 
         template<logging_level L>
         void instance_log_generic(std::string message_) const {
-            if (L < level_console && L < level_seq) return;
+            if (L < level_console.load(std::memory_order_relaxed) && L < effective_level_seq()) return;
             enqueue(std::move(message_), make_context(L));
         }
 
-        void start_thread(int timeout, bool allow_without_seq) {
-            if (!_static_instance) return;
-            _s_thread = std::thread(&seq::send_events_loop_handler, timeout, allow_without_seq);
-            _s_thread.detach();
-            {
-                std::unique_lock<std::mutex> lock_start{_s_thread_started_mutex};
-                _s_thread_started.wait(lock_start);
-            }
+        void start_thread(int timeout, bool allow_without_seq);
+
+        static void signal_ready(bool seq_available_) {
+            std::unique_lock<std::mutex> lock_start{_s_ready_mutex};
+            _s_startup_finished = true;
+            _s_seq_available = seq_available_;
+            _s_ready_changed.notify_all();
+        }
+
+        [[nodiscard]] static seq_metrics &metrics() {
+            return seq_metrics::instance();
         }
 
         [[nodiscard]] static seq &shared_instance() {
+            // Sinks and metrics are used by the final dispatch in the destructor, so they must be constructed before (and
+            // thus destroyed after) the instance
+            static const bool dependencies_constructed = [] {
+                (void) sinks_storage();
+                (void) metrics();
+                (void) seq_memory_budget::instance();
+                return true;
+            }();
+            (void) dependencies_constructed;
             static seq instance(true);
             return instance;
         }
 
         seq_context make_context(logging_level level_, seq_properties_vector_t properties_) const {
             auto ctx = seq_context(level_, std::move(properties_), _name);
+            ctx.scope = &seq_scope_stack::current();
             ctx.append(_properties);
             ctx.append(_s_shared_properties);
             if (!_enrichers.empty()) {
@@ -640,6 +1658,7 @@ namespace seq_logger {
 
         seq_context make_context(logging_level level_) const {
             auto ctx = seq_context(level_, _properties, _name);
+            ctx.scope = &seq_scope_stack::current();
             ctx.append(_s_shared_properties);
             if (!_enrichers.empty()) {
                 for (auto &enricher: _enrichers) {
@@ -655,43 +1674,98 @@ namespace seq_logger {
         }
 
         void enqueue(std::string message_, seq_context &&context_) const {
-            auto *entry = new seq_log_entry(std::move(message_), std::move(context_));
-            static const char esc_char = 27;
-
-            if (entry->context.level >= level_seq) {
-                std::lock_guard<std::mutex> guard(_logs_mutex);
-                _seq_dispatch_queue.push_back(entry);
-            }
-
-            if (entry->context.level >= level_console) {
-                std::stringstream ss;
-                ss << entry->time << "\t" << entry->context.logger_name << "\t["
-                   << logging_level_strings_short[entry->context.level] << "]\t" << esc_char << "[1m"
-                   << entry->message() << esc_char
-                   << "[0m\t\t";
-                if (!entry->context.empty()) {
-                    for (size_t i = 0; i < entry->context.size(); ++i) {
-                        ss << entry->context[i].first << "=" << entry->context[i].second.str_val << " ";
+            seq_event_limits limits;
+            limits.max_message_bytes = _s_max_message_bytes.load(std::memory_order_relaxed);
+            limits.max_properties = _s_max_properties.load(std::memory_order_relaxed);
+            limits.max_property_value_bytes = _s_max_property_value_bytes.load(std::memory_order_relaxed);
+            auto *entry = seq_log_entry::create(message_, context_, limits);
+            if (entry->truncated()) metrics().event_truncated();
+            if (auto *recorder = _s_flight_recorder.load(std::memory_order_acquire)) entry->record_to(*recorder);
+            auto level = entry->level;
+
+            // Synchronous sinks go first: once queued, the entry is owned (and eventually deleted) by the dispatcher
+            if (level >= level_console.load(std::memory_order_relaxed)) {
+                // Held in a local: a range-for over *current_sinks() would destroy the snapshot before the loop body
+                auto sinks = current_sinks();
+                for (const auto &slot: *sinks) {
+                    if (slot.mode != sink_mode::synchronous || level < slot.sink->effective_level()) continue;
+                    std::lock_guard<std::mutex> guard(*slot.mutex);
+                    try {
+                        slot.sink->begin_batch(1);
+                        slot.sink->write(*entry);
+                        slot.sink->end_batch();
+                    } catch (const std::exception &e) {
+                        seq_sink::report_error(e);
                     }
                 }
-                ss << std::endl;
-                if (entry->context.level > logging_level::warning) {
-                    std::cerr << ss.str();
-                    std::cerr.flush();
-                } else {
-                    std::cout << ss.str();
-                    std::cout.flush();
-                }
             }
+
+            bool queued = level >= effective_level_seq();
+            bool priority = level >= priority_level.load(std::memory_order_relaxed);
+            bool over_budget = queued && !priority && !charge_memory_budget(*entry);
+            metrics().event_enqueued(level, queued && !over_budget);
+            if (over_budget) {
+                metrics().events_over_budget(1);
+            } else if (queued) {
+                push_to_queue(entry, priority);
+                if (priority) wake_for_priority();
+                return;
+            } else if (level >= level_seq.load(std::memory_order_relaxed)) {
+                metrics().event_filtered();
+            }
+            delete entry;
+        }
+
+        /// \brief Charge the entry to the memory budget, if there is one, making room according to its drop policy
+        /// \return false if the entry does not fit and has to be dropped
+        bool charge_memory_budget(seq_log_entry &entry_) const {
+            auto &budget = seq_memory_budget::instance();
+            if (budget.max_bytes() == 0) return true;
+            auto bytes = entry_.allocation_bytes();
+            if (!budget.try_charge(bytes) &&
+                (budget.policy() != drop_policy::drop_oldest || !drop_oldest_queued(bytes) || !budget.try_charge(bytes))) {
+                return false;
+            }
+            entry_.budget_bytes = bytes;
+            return true;
         }
 
-        void transfer_logs(std::vector<seq_log_entry *> &queue_) {
+        /// \brief Drop the oldest events queued by all loggers (not their priority lanes), until at least bytes_ of the
+        /// budget are released
+        /// \return Number of events dropped
+        static size_t drop_oldest_queued(size_t bytes_);
+
+        /// \brief Stamp the entry with the next global sequence number and queue it. Stamping under the queue lock keeps
+        /// every queue in sequence order, which dispatch_events relies on to merge them
+        void push_to_queue(seq_log_entry *entry_, bool priority_ = false) const {
             std::lock_guard<std::mutex> guard(_logs_mutex);
-            _seq_dispatch_queue.reserve(_seq_dispatch_queue.size() + queue_.size());
-            _seq_dispatch_queue.insert(_seq_dispatch_queue.end(), queue_.begin(), queue_.end());
+            entry_->sequence = _s_sequence.fetch_add(1, std::memory_order_relaxed);
+            (priority_ ? _seq_priority_queue : _seq_dispatch_queue).push_back(entry_);
         }
 
+        /// \brief Wake the dispatcher to dispatch the priority lane, once until it did. Not from threads of the logger,
+        /// their priority events wait for the next dispatch
+        static void wake_for_priority() {
+            if (in_logger_thread() || _s_priority_pending.exchange(true, std::memory_order_relaxed)) return;
+            // Under the mutex, so the wake-up cannot slip in between the dispatcher checking the flag and waiting
+            std::lock_guard<std::mutex> guard(_s_thread_finished_mutex);
+            _s_dispatcher_wake.notify_all();
+        }
+
+        void transfer_logs(std::vector<seq_log_entry *> &queue_, bool priority_) {
+            std::lock_guard<std::mutex> guard(_logs_mutex);
+            auto &queue = priority_ ? _seq_priority_queue : _seq_dispatch_queue;
+            auto middle = queue.size();
+            queue.insert(queue.end(), queue_.begin(), queue_.end());
+            std::inplace_merge(queue.begin(), queue.begin() + middle, queue.end(),
+                               [](const seq_log_entry *l_, const seq_log_entry *r_) { return l_->sequence < r_->sequence; });
+        }
+
+        /// \brief Apply the config rules to logger_ and add it to _s_loggers in one step, so that a config reload
+        /// cannot fall in between and miss the logger
         static void register_logger(seq *logger_) {
+            std::lock_guard<std::mutex> config_guard(_s_level_config_mutex);
+            apply_level_config_locked(*logger_);
             std::lock_guard<std::mutex> guard(_s_loggers_mutex);
             _s_loggers.push_back(logger_);
         }
@@ -706,11 +1780,120 @@ namespace seq_logger {
             }
         }
 
-        void finish_initialization(const char *name_) {
-            level_console = base_level_console;
-            level_seq = base_level_seq;
-            std::strcpy(_name, name_);
+        void finish_initialization(const char *name_, logging_level console_verbosity_, logging_level seq_verbosity_) {
+            level_console.store(console_verbosity_, std::memory_order_relaxed);
+            level_seq.store(seq_verbosity_, std::memory_order_relaxed);
+            _name = name_ == nullptr ? "Default" : name_;
             register_logger(this);
         }
+
+        [[nodiscard]] static registry_shard &registry_shard_for(std::string_view name_);
+
+        ///\brief The config file of watch_level_config and the thread waiting for its changes, defined in seq_impl.hpp
+        struct level_config_watch;
+
+        [[nodiscard]] static level_config_watch &level_config_watching();
+
+        ///\brief Body of the thread of watch_level_config, re-reads the rules whenever watcher_ reports a change
+        static void level_config_loop(config_file_watcher *watcher_);
+
+        /// \brief Levels of the most specific set_levels() rule for name_, console_/seq_ are left unchanged if none matches
+        static void find_level_rule(std::string_view name_, logging_level &console_, logging_level &seq_) {
+            std::lock_guard<std::mutex> guard(_s_level_rules_mutex);
+            if (_s_level_rules.empty()) return;
+            std::string name(name_);
+            for (;;) {
+                auto found = _s_level_rules.find(name);
+                if (found != _s_level_rules.end()) {
+                    console_ = found->second.first;
+                    seq_ = found->second.second;
+                    return;
+                }
+                auto separator = name.rfind('.');
+                if (separator == std::string::npos) return;
+                name.resize(separator);
+            }
+        }
+
+        /// \brief Apply the last env/config rule matching the logger, or restore its own levels if none matches anymore.
+        /// Requires _s_level_config_mutex
+        static void apply_level_config_locked(seq &logger_);
+
+        /// \brief Requires _s_level_config_mutex
+        static void apply_level_config_to_all() {
+            std::lock_guard<std::mutex> guard(_s_loggers_mutex);
+            for (auto *logger: _s_loggers) {
+                apply_level_config_locked(*logger);
+            }
+        }
+
+        /// \brief Re-read the watched config file if it changed, a file that cannot be read keeps the previous rules.
+        /// Requires _s_level_config_mutex
+        static void poll_level_config();
     };
-}
\ No newline at end of file
+
+    ///\brief Logger created with seq::child(), see there
+    class seq_child_logger {
+    public:
+        ///\param parent_ Owning, or non-owning (aliasing an empty shared_ptr) for loggers not owned by a shared_ptr
+        seq_child_logger(std::shared_ptr<const seq> parent_, seq_properties_vector_t &&properties_)
+                : _parent(std::move(parent_)), _properties(std::move(properties_)) {}
+
+        ///\brief Child of this child, with the properties of both
+        [[nodiscard]] seq_child_logger child(seq_properties_vector_t &&properties_) const {
+            seq_properties_vector_t properties(std::move(properties_));
+            properties.insert(properties.end(), _properties.begin(), _properties.end());
+            return {_parent, std::move(properties)};
+        }
+
+        /// \brief Add a property to all logs of this child
+        void add_property(std::string key_, stringified_value val_) {
+            _properties.emplace_back(std::move(key_), std::move(val_));
+        }
+
+        void verbose(std::string message_, seq_properties_vector_t &&properties_ = {}) const {
+            log_generic<logging_level::verbose>(std::move(message_), std::move(properties_));
+        }
+
+        void debug(std::string message_, seq_properties_vector_t &&properties_ = {}) const {
+            log_generic<logging_level::debug>(std::move(message_), std::move(properties_));
+        }
+
+        void info(std::string message_, seq_properties_vector_t &&properties_ = {}) const {
+            log_generic<logging_level::info>(std::move(message_), std::move(properties_));
+        }
+
+        void warning(std::string message_, seq_properties_vector_t &&properties_ = {}) const {
+            log_generic<logging_level::warning>(std::move(message_), std::move(properties_));
+        }
+
+        void error(std::string message_, seq_properties_vector_t &&properties_ = {}) const {
+            log_generic<logging_level::error>(std::move(message_), std::move(properties_));
+        }
+
+        void fatal(std::string message_, seq_properties_vector_t &&properties_ = {}) const {
+            log_generic<logging_level::fatal>(std::move(message_), std::move(properties_));
+        }
+
+    private:
+        template<logging_level L>
+        void log_generic(std::string message_, seq_properties_vector_t &&properties_) const {
+            if (L < _parent->level_console.load(std::memory_order_relaxed) && L < _parent->effective_level_seq()) return;
+            properties_.insert(properties_.end(), _properties.begin(), _properties.end());
+            _parent->enqueue(std::move(message_), _parent->make_context(L, std::move(properties_)));
+        }
+
+        std::shared_ptr<const seq> _parent;
+        seq_properties_vector_t _properties;
+    };
+
+    inline seq_child_logger seq::child(seq_properties_vector_t &&properties_) const {
+        std::shared_ptr<const seq> parent = weak_from_this().lock();
+        if (!parent) parent = std::shared_ptr<const seq>(std::shared_ptr<const seq>(), this);
+        return {std::move(parent), std::move(properties_)};
+    }
+}
+
+#ifndef SEQ_LOGGER_COMPILED_LIB
+#  include "seq_impl.hpp"
+#endif // SEQ_LOGGER_COMPILED_LIB
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace seq_logger {
+    ///\brief Compact binary event encoding, written as append-only segment files.
+    ///
+    /// Segment layout: "SEQB" magic, format version byte, 3 reserved bytes, followed by records:
+    /// - string definition: tag_string, varint id, varint length, bytes
+    /// - event: tag_event, level byte, zigzag varint timestamp delta (100ns ticks since the previous event of the
+    ///   segment, the first one is relative to the epoch), message ref, logger ref, varint property count and
+    ///   for each property a key ref followed by a typed value
+    ///
+    /// A ref is a varint: 0 means an inline string follows (varint length, bytes), n > 0 refers to the string
+    /// defined with id n - 1. Templates, logger names and property keys are interned per segment (up to
+    /// max_interned_strings), so every segment can be decoded on its own.
+    struct binary_format {
+        static constexpr char magic[4] = {'S', 'E', 'Q', 'B'};
+        ///\brief Version 1 stored timestamps in microseconds, its segments are still read
+        static constexpr uint8_t version = 2;
+        static constexpr size_t header_size = 8;
+
+        static constexpr uint8_t tag_string = 0x01;
+        static constexpr uint8_t tag_event = 0x02;
+
+        static constexpr uint8_t value_string = 0x00;
+        static constexpr uint8_t value_integer = 0x01;
+
+        static constexpr size_t max_interned_strings = 65536;
+
+        ///\brief Unit of timestamps, the resolution of Seq
+        typedef std::chrono::duration<int64_t, std::ratio<1, 10000000>> ticks;
+
+        static void put_varint(std::string &out_, uint64_t value_) {
+            while (value_ >= 0x80) {
+                out_.push_back(static_cast<char>((value_ & 0x7F) | 0x80));
+                value_ >>= 7;
+            }
+            out_.push_back(static_cast<char>(value_));
+        }
+
+        static uint64_t zigzag(int64_t value_) {
+            return (static_cast<uint64_t>(value_) << 1) ^ static_cast<uint64_t>(value_ >> 63);
+        }
+
+        static int64_t unzigzag(uint64_t value_) {
+            return static_cast<int64_t>(value_ >> 1) ^ -static_cast<int64_t>(value_ & 1);
+        }
+
+        ///\brief Whether the value is the canonical decimal representation of an int64, so it can be stored as a
+        /// varint and decoded back to exactly the same text
+        static bool parse_integer(std::string_view value_, int64_t &result_) {
+            size_t i = 0;
+            bool negative = !value_.empty() && value_[0] == '-';
+            if (negative) ++i;
+            size_t digits = value_.size() - i;
+            if (digits == 0 || digits > 18) return false;
+            if (value_[i] == '0' && (digits > 1 || negative)) return false;
+            int64_t result = 0;
+            for (; i < value_.size(); ++i) {
+                if (value_[i] < '0' || value_[i] > '9') return false;
+                result = result * 10 + (value_[i] - '0');
+            }
+            result_ = negative ? -result : result;
+            return true;
+        }
+    };
+
+    ///\brief Writes events to append-only binary segment files, rotating once a segment exceeds max_segment_bytes_.
+    /// Not thread safe, meant to be driven by the dispatcher thread
+    class binary_segment_writer {
+    public:
+        binary_segment_writer(std::string directory_, std::string prefix_, size_t max_segment_bytes_)
+                : _directory(std::move(directory_)), _prefix(std::move(prefix_)),
+                  _max_segment_bytes(max_segment_bytes_) {
+            _buffer.reserve(buffer_size * 2);
+        }
+
+        ~binary_segment_writer() {
+            close();
+        }
+
+        binary_segment_writer(binary_segment_writer const &) = delete;
+
+        binary_segment_writer &operator=(binary_segment_writer const &) = delete;
+
+        ///\brief Start an event, must be followed by exactly property_count_ add_property calls
+        void begin_event(uint8_t level_, int64_t timestamp_ticks_, std::string_view message_, std::string_view logger_,
+                         size_t property_count_) {
+            if (_file == nullptr || _segment_bytes + _buffer.size() >= _max_segment_bytes) open_segment();
+            _event.clear();
+            _event.push_back(static_cast<char>(binary_format::tag_event));
+            _event.push_back(static_cast<char>(level_));
+            binary_format::put_varint(_event, binary_format::zigzag(timestamp_ticks_ - _last_timestamp_ticks));
+            _last_timestamp_ticks = timestamp_ticks_;
+            put_ref(message_);
+            put_ref(logger_);
+            binary_format::put_varint(_event, property_count_);
+        }
+
+        void add_property(std::string_view key_, std::string_view value_) {
+            put_ref(key_);
+            int64_t integer;
+            if (binary_format::parse_integer(value_, integer)) {
+                _event.push_back(static_cast<char>(binary_format::value_integer));
+                binary_format::put_varint(_event, binary_format::zigzag(integer));
+            } else {
+                _event.push_back(static_cast<char>(binary_format::value_string));
+                binary_format::put_varint(_event, value_.size());
+                _event.append(value_);
+            }
+        }
+
+        void end_event() {
+            _buffer.append(_event);
+            if (_buffer.size() >= buffer_size) flush();
+        }
+
+        ///\brief Write buffered records to the current segment
+        void flush() {
+            if (_file == nullptr || _buffer.empty()) return;
+            if (std::fwrite(_buffer.data(), 1, _buffer.size(), _file) != _buffer.size()) {
+                throw std::runtime_error("Failed to write binary log segment");
+            }
+            std::fflush(_file);
+            _segment_bytes += _buffer.size();
+            _buffer.clear();
+        }
+
+        void close() {
+            if (_file == nullptr) return;
+            try {
+                flush();
+            } catch (const std::exception &) {}
+            std::fclose(_file);
+            _file = nullptr;
+        }
+
+        [[nodiscard]] const std::string &segment_path() const {
+            return _segment_path;
+        }
+
+    private:
+        static constexpr size_t buffer_size = 64 * 1024;
+
+        void open_segment() {
+            close();
+            auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+            char name[64];
+            std::snprintf(name, sizeof(name), "-%013lld-%04u.seqb", static_cast<long long>(now_ms), _segment_index++ % 10000);
+            _segment_path = _directory + "/" + _prefix + name;
+            _file = std::fopen(_segment_path.c_str(), "ab");
+            if (_file == nullptr) {
+                throw std::runtime_error("Failed to open binary log segment " + _segment_path);
+            }
+            _interned.clear();
+            _interned_storage.clear();
+            _last_timestamp_ticks = 0;
+            _segment_bytes = 0;
+            _buffer.append(binary_format::magic, sizeof(binary_format::magic));
+            _buffer.push_back(static_cast<char>(binary_format::version));
+            _buffer.append(3, '\0');
+        }
+
+        void put_ref(std::string_view value_) {
+            auto found = _interned.find(value_);
+            if (found != _interned.end()) {
+                binary_format::put_varint(_event, found->second + 1);
+                return;
+            }
+            if (_interned.size() < binary_format::max_interned_strings) {
+                auto id = static_cast<uint32_t>(_interned.size());
+                _interned.emplace(_interned_storage.emplace_back(value_), id);
+                _buffer.push_back(static_cast<char>(binary_format::tag_string));
+                binary_format::put_varint(_buffer, id);
+                binary_format::put_varint(_buffer, value_.size());
+                _buffer.append(value_);
+                binary_format::put_varint(_event, id + 1);
+                return;
+            }
+            binary_format::put_varint(_event, 0);
+            binary_format::put_varint(_event, value_.size());
+            _event.append(value_);
+        }
+
+        std::string _directory;
+        std::string _prefix;
+        size_t _max_segment_bytes;
+        std::string _segment_path;
+        unsigned _segment_index{0};
+        std::FILE *_file{nullptr};
+        size_t _segment_bytes{0};
+        int64_t _last_timestamp_ticks{0};
+        std::unordered_map<std::string_view, uint32_t> _interned;
+        std::deque<std::string> _interned_storage;
+        std::string _buffer;
+        std::string _event;
+    };
+
+    ///\brief Event decoded from a binary segment, views point into the reader's buffers
+    struct binary_event {
+        uint8_t level{0};
+        ///\brief binary_format::ticks since the epoch
+        int64_t timestamp_ticks{0};
+        std::string_view message;
+        std::string_view logger;
+        std::vector<std::pair<std::string_view, std::string>> properties;
+    };
+
+    ///\brief Decodes binary segments written by binary_segment_writer
+    class binary_segment_reader {
+    public:
+        ///\brief Decode the whole segment, calling handler_ for every event. A truncated trailing record (e.g. the
+        /// process died mid-write) ends decoding silently, a corrupted segment throws
+        ///\return Number of decoded events
+        static size_t read_file(const std::string &path_, const std::function<void(const binary_event &)> &handler_) {
+            std::FILE *file = std::fopen(path_.c_str(), "rb");
+            if (file == nullptr) throw std::runtime_error("Failed to open " + path_);
+            std::string data;
+            char chunk[65536];
+            size_t read;
+            while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) data.append(chunk, read);
+            std::fclose(file);
+            return read_buffer(data, handler_);
+        }
+
+        static size_t read_buffer(std::string_view data_, const std::function<void(const binary_event &)> &handler_) {
+            if (data_.size() < binary_format::header_size ||
+                std::memcmp(data_.data(), binary_format::magic, sizeof(binary_format::magic)) != 0) {
+                throw std::runtime_error("Not a binary log segment");
+            }
+            auto version = static_cast<uint8_t>(data_[4]);
+            if (version != binary_format::version && version != 1) {
+                throw std::runtime_error("Unsupported binary log segment version");
+            }
+            int64_t ticks_per_unit = version == 1 ? 10 : 1;
+
+            cursor c{data_, binary_format::header_size};
+            std::vector<std::string_view> strings;
+            int64_t last_timestamp = 0;
+            size_t events = 0;
+            binary_event event;
+            try {
+                while (c.position < data_.size()) {
+                    auto tag = c.byte();
+                    if (tag == binary_format::tag_string) {
+                        auto id = c.varint();
+                        if (id != strings.size()) throw std::runtime_error("Corrupted segment: unexpected string id");
+                        strings.push_back(c.bytes(c.varint()));
+                    } else if (tag == binary_format::tag_event) {
+                        event.level = c.byte();
+                        last_timestamp += binary_format::unzigzag(c.varint());
+                        event.timestamp_ticks = last_timestamp * ticks_per_unit;
+                        event.message = c.ref(strings);
+                        event.logger = c.ref(strings);
+                        auto count = c.varint();
+                        event.properties.clear();
+                        for (uint64_t i = 0; i < count; ++i) {
+                            auto key = c.ref(strings);
+                            auto type = c.byte();
+                            if (type == binary_format::value_integer) {
+                                event.properties.emplace_back(key, std::to_string(binary_format::unzigzag(c.varint())));
+                            } else if (type == binary_format::value_string) {
+                                event.properties.emplace_back(key, std::string(c.bytes(c.varint())));
+                            } else {
+                                throw std::runtime_error("Corrupted segment: unknown value type");
+                            }
+                        }
+                        handler_(event);
+                        ++events;
+                    } else {
+                        throw std::runtime_error("Corrupted segment: unknown record");
+                    }
+                }
+            } catch (const truncated &) {}
+            return events;
+        }
+
+    private:
+        struct truncated {};
+
+        struct cursor {
+            std::string_view data;
+            size_t position;
+
+            uint8_t byte() {
+                if (position >= data.size()) throw truncated{};
+                return static_cast<uint8_t>(data[position++]);
+            }
+
+            uint64_t varint() {
+                uint64_t result = 0;
+                for (int shift = 0; shift < 64; shift += 7) {
+                    auto b = byte();
+                    result |= static_cast<uint64_t>(b & 0x7F) << shift;
+                    if ((b & 0x80) == 0) return result;
+                }
+                throw std::runtime_error("Corrupted segment: varint too long");
+            }
+
+            std::string_view bytes(uint64_t length_) {
+                if (length_ > data.size() - position) throw truncated{};
+                auto result = data.substr(position, length_);
+                position += length_;
+                return result;
+            }
+
+            std::string_view ref(const std::vector<std::string_view> &strings_) {
+                auto id = varint();
+                if (id == 0) return bytes(varint());
+                if (id > strings_.size()) throw std::runtime_error("Corrupted segment: unknown string ref");
+                return strings_[id - 1];
+            }
+        };
+    };
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <mutex>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#  define SEQ_LOGGER_HAS_TSC 1
+#  if defined(_MSC_VER)
+// Declared instead of including <intrin.h>, which is heavy for a header included by every user of the logger
+extern "C" unsigned __int64 __rdtsc();
+#    pragma intrinsic(__rdtsc)
+#  endif // defined(_MSC_VER)
+#endif // defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+
+namespace seq_logger {
+    ///\brief Source of event timestamps, see seq_clock::use
+    enum class clock_source {
+        ///\brief std::chrono::system_clock::now()
+        system,
+        ///\brief CPU timestamp counter, scaled to system_clock and periodically re-aligned with it
+        tsc
+    };
+
+    ///\brief Clock for event timestamps. With clock_source::tsc, now() reads the (invariant) timestamp counter and
+    /// converts it with the last calibration, which the dispatcher thread refreshes through calibrate(). Corrections
+    /// are applied by adjusting the rate, so timestamps stay continuous and monotonic. The calibration is defined in
+    /// seq_impl.hpp, keeping the cpuid headers out of seq.hpp
+    class seq_clock {
+    public:
+        typedef std::chrono::system_clock::time_point time_point;
+
+        ///\brief Length of a timestamp written by append_iso8601, e.g. 2024-05-01T13:45:12.1234567+02:00
+        static constexpr size_t iso8601_length = 33;
+
+        [[nodiscard]] static time_point now() {
+#ifdef SEQ_LOGGER_HAS_TSC
+            if (_source.load(std::memory_order_relaxed) == clock_source::tsc) {
+                return time_point(std::chrono::duration_cast<time_point::duration>(std::chrono::nanoseconds(from_tsc(read_tsc()))));
+            }
+#endif // SEQ_LOGGER_HAS_TSC
+            return std::chrono::system_clock::now();
+        }
+
+        ///\brief Switch the timestamp source. Enabling the TSC clock measures its rate for a few milliseconds
+        ///\return false if the TSC clock is unavailable (no invariant TSC), in which case system_clock stays in use
+        static bool use(clock_source source_);
+
+        [[nodiscard]] static clock_source source() {
+            return _source.load(std::memory_order_relaxed);
+        }
+
+        ///\brief Re-align the TSC clock with system_clock (at most once per second), no-op for the system clock.
+        /// The rate for the next interval is chosen so the TSC clock converges to system_clock instead of jumping,
+        /// unless they drifted apart by more than a second (e.g. the system clock was stepped)
+        static void calibrate();
+
+        ///\brief Append t_ as ISO-8601 local time with 100ns precision (the resolution of Seq) and UTC offset.
+        /// The date/time part is cached per thread and only recomputed when the second changes
+        static void append_iso8601(std::string &out_, time_point t_) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t_.time_since_epoch()).count();
+            auto seconds = ns / 1000000000;
+            auto fraction = ns % 1000000000;
+            if (fraction < 0) {
+                fraction += 1000000000;
+                --seconds;
+            }
+
+            thread_local int64_t cached_second = INT64_MIN;
+            thread_local char date_time[20];
+            thread_local char offset[7];
+            if (seconds != cached_second) {
+                auto raw = static_cast<time_t>(seconds);
+                std::tm local{};
+#if defined(_WIN32) || defined(__CYGWIN__)
+                localtime_s(&local, &raw);
+                std::tm local_copy = local;
+                long offset_seconds = static_cast<long>(_mkgmtime(&local_copy) - raw);
+#else
+                localtime_r(&raw, &local);
+                long offset_seconds = local.tm_gmtoff;
+#endif // defined(_WIN32) || defined(__CYGWIN__)
+                std::strftime(date_time, sizeof(date_time), "%Y-%m-%dT%H:%M:%S", &local);
+                auto offset_minutes = std::labs(offset_seconds) / 60;
+                offset[0] = offset_seconds < 0 ? '-' : '+';
+                offset[1] = static_cast<char>('0' + offset_minutes / 600);
+                offset[2] = static_cast<char>('0' + offset_minutes / 60 % 10);
+                offset[3] = ':';
+                offset[4] = static_cast<char>('0' + offset_minutes % 60 / 10);
+                offset[5] = static_cast<char>('0' + offset_minutes % 10);
+                cached_second = seconds;
+            }
+
+            char digits[8];
+            digits[0] = '.';
+            auto ticks = fraction / 100;
+            for (int i = 7; i > 0; --i) {
+                digits[i] = static_cast<char>('0' + ticks % 10);
+                ticks /= 10;
+            }
+            out_.append(date_time, 19);
+            out_.append(digits, 8);
+            out_.append(offset, 6);
+        }
+
+    private:
+        static int64_t system_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+#ifdef SEQ_LOGGER_HAS_TSC
+        static uint64_t read_tsc() {
+#if defined(_MSC_VER)
+            return __rdtsc();
+#else
+            return __builtin_ia32_rdtsc();
+#endif // defined(_MSC_VER)
+        }
+
+        static bool has_invariant_tsc();
+
+        ///\brief Nanoseconds since the epoch for a TSC reading, using a consistent snapshot of the calibration
+        static int64_t from_tsc(uint64_t tsc_) {
+            for (;;) {
+                auto version = _calibration.version.load(std::memory_order_acquire);
+                if (version & 1) continue;
+                auto base_tsc = _calibration.tsc.load(std::memory_order_relaxed);
+                auto base_ns = _calibration.ns.load(std::memory_order_relaxed);
+                auto ns_per_tick = _calibration.ns_per_tick.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (_calibration.version.load(std::memory_order_relaxed) != version) continue;
+                auto ticks = static_cast<int64_t>(tsc_ - base_tsc);
+                return base_ns + static_cast<int64_t>(static_cast<double>(ticks) * ns_per_tick);
+            }
+        }
+
+        ///\brief Publish a calibration, writers are serialized by _calibration_mutex (seqlock)
+        static void store_calibration(uint64_t tsc_, int64_t ns_, double ns_per_tick_) {
+            auto version = _calibration.version.load(std::memory_order_relaxed);
+            _calibration.version.store(version + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            _calibration.tsc.store(tsc_, std::memory_order_relaxed);
+            _calibration.ns.store(ns_, std::memory_order_relaxed);
+            _calibration.ns_per_tick.store(ns_per_tick_, std::memory_order_relaxed);
+            _calibration.version.store(version + 2, std::memory_order_release);
+        }
+
+        ///\brief Only used with static storage duration, so zero-initialized
+        struct calibration {
+            std::atomic<uint32_t> version;
+            std::atomic<uint64_t> tsc;
+            std::atomic<int64_t> ns;
+            std::atomic<double> ns_per_tick;
+        };
+
+        inline static calibration _calibration;
+        inline static std::mutex _calibration_mutex;
+        inline static uint64_t _last_sync_tsc{0};
+        inline static int64_t _last_sync_ns{0};
+#endif // SEQ_LOGGER_HAS_TSC
+
+        inline static std::atomic<clock_source> _source{clock_source::system};
+    };
+}
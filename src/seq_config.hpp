@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(__linux__)
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <sys/inotify.h>
+#  include <unistd.h>
+#endif // defined(__linux__)
+#include <sys/stat.h>
+
+namespace seq_logger {
+    ///\brief Whether text_ matches pattern_, where '*' matches any run of characters (including dots) and '?' any
+    /// single character, e.g. "Billing.*" matches "Billing.Invoices.Pdf"
+    inline bool glob_match(std::string_view pattern_, std::string_view text_) {
+        size_t p = 0, t = 0;
+        size_t star = std::string_view::npos, star_text = 0;
+        while (t < text_.size()) {
+            if (p < pattern_.size() && (pattern_[p] == '?' || pattern_[p] == text_[t])) {
+                ++p;
+                ++t;
+            } else if (p < pattern_.size() && pattern_[p] == '*') {
+                star = p++;
+                star_text = t;
+            } else if (star != std::string_view::npos) {
+                p = star + 1;
+                t = ++star_text;
+            } else {
+                return false;
+            }
+        }
+        while (p < pattern_.size() && pattern_[p] == '*') ++p;
+        return p == pattern_.size();
+    }
+
+    ///\brief Read a whole (small) file, returns false if it cannot be opened
+    inline bool read_text_file(const std::string &path_, std::string &content_) {
+        std::FILE *file = std::fopen(path_.c_str(), "rb");
+        if (file == nullptr) return false;
+        content_.clear();
+        char chunk[4096];
+        size_t read;
+        while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) content_.append(chunk, read);
+        std::fclose(file);
+        return true;
+    }
+
+    ///\brief Change detection for a configuration file, either polled with changed() or waited for with wait() from a
+    /// dedicated thread. Uses inotify on Linux, watching the directory so that editors replacing the file are noticed as
+    /// well, and the modification time and size elsewhere
+    class config_file_watcher {
+    public:
+        explicit config_file_watcher(std::string path_) : _path(std::move(path_)) {
+#if defined(__linux__)
+            auto separator = _path.find_last_of('/');
+            auto directory = separator == std::string::npos ? std::string(".") : _path.substr(0, separator == 0 ? 1 : separator);
+            _file_name = separator == std::string::npos ? _path : _path.substr(separator + 1);
+            _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (_fd >= 0 && inotify_add_watch(_fd, directory.c_str(),
+                                              IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE) < 0) {
+                ::close(_fd);
+                _fd = -1;
+            }
+            if (_fd >= 0 && ::pipe2(_wake, O_NONBLOCK | O_CLOEXEC) != 0) {
+                _wake[0] = _wake[1] = -1;
+            }
+#endif // defined(__linux__)
+        }
+
+        ~config_file_watcher() {
+#if defined(__linux__)
+            if (_fd >= 0) ::close(_fd);
+            for (int fd: _wake) {
+                if (fd >= 0) ::close(fd);
+            }
+#endif // defined(__linux__)
+        }
+
+        config_file_watcher(config_file_watcher const &) = delete;
+
+        config_file_watcher &operator=(config_file_watcher const &) = delete;
+
+        ///\return Whether the file changed since the previous call, true on the first call
+        bool changed() {
+            if (_first) {
+                _first = false;
+                stat_changed();
+                return true;
+            }
+#if defined(__linux__)
+            if (_fd >= 0) return inotify_changed();
+#endif // defined(__linux__)
+            return stat_changed();
+        }
+
+        ///\brief Blocks until the file may have changed, i.e. on an inotify event for its directory or, when polling the
+        /// modification time, once timeout_ elapsed. Follow with changed()
+        ///\return false once interrupt() was called
+        bool wait(std::chrono::milliseconds timeout_) {
+#if defined(__linux__)
+            if (_fd >= 0 && _wake[0] >= 0) {
+                pollfd fds[2]{{_fd, POLLIN, 0}, {_wake[0], POLLIN, 0}};
+                int ready;
+                do {
+                    ready = ::poll(fds, 2, -1);
+                } while (ready < 0 && errno == EINTR);
+                if (ready > 0) return (fds[1].revents & POLLIN) == 0;
+            }
+#endif // defined(__linux__)
+            std::unique_lock<std::mutex> lock(_interrupt_mutex);
+            return !_interrupt_wake.wait_for(lock, timeout_, [this] { return _interrupted; });
+        }
+
+        ///\brief Makes the current and all later wait() calls return false, callable from any thread
+        void interrupt() {
+#if defined(__linux__)
+            if (_wake[1] >= 0) {
+                char byte(0);
+                (void) !::write(_wake[1], &byte, 1);
+            }
+#endif // defined(__linux__)
+            {
+                std::lock_guard<std::mutex> guard(_interrupt_mutex);
+                _interrupted = true;
+            }
+            _interrupt_wake.notify_all();
+        }
+
+        [[nodiscard]] const std::string &path() const {
+            return _path;
+        }
+
+    private:
+#if defined(__linux__)
+        bool inotify_changed() {
+            bool changed(false);
+            alignas(inotify_event) char buffer[4096];
+            for (;;) {
+                auto length = ::read(_fd, buffer, sizeof(buffer));
+                if (length <= 0) break;
+                for (char *p = buffer; p < buffer + length;) {
+                    auto *event = reinterpret_cast<inotify_event *>(p);
+                    if ((event->mask & IN_Q_OVERFLOW) != 0 ||
+                        (event->len > 0 && _file_name == event->name)) {
+                        changed = true;
+                    }
+                    p += sizeof(inotify_event) + event->len;
+                }
+            }
+            return changed;
+        }
+#endif // defined(__linux__)
+
+        bool stat_changed() {
+            struct stat info{};
+            long long modified = -1, size = -1;
+            if (::stat(_path.c_str(), &info) == 0) {
+                modified = static_cast<long long>(info.st_mtime);
+                size = static_cast<long long>(info.st_size);
+            }
+            bool changed = modified != _modified || size != _size;
+            _modified = modified;
+            _size = size;
+            return changed;
+        }
+
+        std::string _path;
+        bool _first{true};
+        long long _modified{-1};
+        long long _size{-1};
+        std::mutex _interrupt_mutex;
+        std::condition_variable _interrupt_wake;
+        bool _interrupted{false};
+#if defined(__linux__)
+        std::string _file_name;
+        int _fd{-1};
+        int _wake[2]{-1, -1};
+#endif // defined(__linux__)
+    };
+}
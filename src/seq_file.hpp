@@ -0,0 +1,248 @@
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+#  include <io.h>
+#else
+#  include <fcntl.h>
+#  include <spawn.h>
+#  include <sys/stat.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+
+extern char **environ;
+#endif // defined(_WIN32) || defined(__CYGWIN__)
+
+#include "seq_uring.hpp"
+
+namespace seq_logger {
+    ///\brief Append-only file with a large userspace buffer, rotated by size and age.
+    /// Rotated files are renamed to <stem>.<yyyymmdd-hhmmss>[-n]<extension> and optionally gzip-ed in the background.
+    /// With file_write_backend::io_uring the buffer is double buffered: flush() queues it on the shared io_uring and
+    /// continues with the other one, the write is awaited before the next flush.
+    /// Not thread safe, meant to be driven by the dispatcher thread
+    class rolling_file_writer {
+    public:
+        ///\param path_ Path of the active file, e.g. /var/log/service.clef
+        ///\param max_file_bytes_ Size after which the file is rotated, 0 disables size based rotation
+        ///\param max_file_age_ Age after which the file is rotated, zero disables time based rotation
+        ///\param compress_rotated_ Compress rotated files with gzip in the background
+        ///\param buffer_bytes_ Userspace buffer size, data is written once the buffer is full or on flush()
+        ///\param backend_ Whether flush() writes the buffer itself or queues it on io_uring_write_queue::shared()
+        rolling_file_writer(std::string path_, size_t max_file_bytes_, std::chrono::seconds max_file_age_,
+                            bool compress_rotated_, size_t buffer_bytes_ = 1024 * 1024,
+                            file_write_backend backend_ = file_write_backend::blocking)
+                : _path(std::move(path_)), _max_file_bytes(max_file_bytes_), _max_file_age(max_file_age_),
+                  _compress_rotated(compress_rotated_), _buffer_bytes(buffer_bytes_),
+                  _uring(backend_ == file_write_backend::io_uring ? io_uring_write_queue::shared() : nullptr) {
+            _buffer.reserve(_buffer_bytes);
+            if (_uring != nullptr) _queued.reserve(_buffer_bytes);
+        }
+
+        ~rolling_file_writer() {
+            try {
+                close();
+            } catch (const std::exception &) {}
+        }
+
+        rolling_file_writer(rolling_file_writer const &) = delete;
+
+        rolling_file_writer &operator=(rolling_file_writer const &) = delete;
+
+        void write(std::string_view data_) {
+            if (_buffer.size() + data_.size() > _buffer_bytes) flush();
+            if (data_.size() > _buffer_bytes) {
+                write_through(data_.data(), data_.size());
+                return;
+            }
+            _buffer.append(data_);
+        }
+
+        ///\brief Write out the buffer (or queue it with io_uring), rotating the file first if it is due
+        void flush() {
+            if (_buffer.empty()) return;
+            if (_uring == nullptr) {
+                write_through(_buffer.data(), _buffer.size());
+                _buffer.clear();
+                return;
+            }
+            complete_queued_write();
+            if (_fd == invalid || rotation_due(_buffer.size())) rotate();
+            _queued.swap(_buffer);
+            _buffer.clear();
+            _uring->write(_fd, _queued.data(), static_cast<uint32_t>(_queued.size()), _queued_request);
+            _write_queued = true;
+            _file_bytes += _queued.size();
+        }
+
+        void close() {
+            flush();
+            complete_queued_write();
+            close_file();
+        }
+
+        [[nodiscard]] const std::string &path() const {
+            return _path;
+        }
+
+        ///\brief Whether flush() queues writes on io_uring (false if it was requested but is unavailable)
+        [[nodiscard]] bool uses_io_uring() const {
+            return _uring != nullptr;
+        }
+
+    private:
+        ///\brief Wait for the write queued by the previous flush(), writing what a short write left out
+        void complete_queued_write() {
+            if (!_write_queued) return;
+            _write_queued = false;
+            _uring->wait(_queued_request);
+            auto result = _queued_request.result;
+            if (result < 0) {
+                _file_bytes -= _queued.size();
+                throw std::system_error{-result, std::system_category(), "Failed to write " + _path};
+            }
+            auto remaining = _queued.size() - static_cast<size_t>(result);
+            if (remaining > 0) {
+                _file_bytes -= remaining;
+                write_all(_queued.data() + result, remaining);
+            }
+        }
+
+        void write_through(const char *data_, size_t size_) {
+            complete_queued_write();
+            if (_fd == invalid || rotation_due(size_)) rotate();
+            write_all(data_, size_);
+        }
+
+        void write_all(const char *data_, size_t size_) {
+            while (size_ > 0) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+                auto written = ::_write(_fd, data_, static_cast<unsigned int>(size_));
+#else
+                auto written = ::write(_fd, data_, size_);
+                if (written < 0 && errno == EINTR) continue;
+#endif // defined(_WIN32) || defined(__CYGWIN__)
+                if (written < 0) throw std::system_error{errno, std::system_category(), "Failed to write " + _path};
+                data_ += written;
+                size_ -= static_cast<size_t>(written);
+                _file_bytes += static_cast<size_t>(written);
+            }
+        }
+
+        [[nodiscard]] bool rotation_due(size_t incoming_) const {
+            if (_file_bytes == 0) return false;
+            if (_max_file_bytes > 0 && _file_bytes + incoming_ > _max_file_bytes) return true;
+            return _max_file_age.count() > 0 && std::chrono::steady_clock::now() - _opened >= _max_file_age;
+        }
+
+        void rotate() {
+            if (_fd != invalid) {
+                close_file();
+                auto rotated = rotated_path();
+                if (std::rename(_path.c_str(), rotated.c_str()) == 0 && _compress_rotated) {
+                    compress_in_background(rotated);
+                }
+            }
+            open_file();
+        }
+
+        void open_file() {
+#if defined(_WIN32) || defined(__CYGWIN__)
+            _fd = ::_open(_path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+            _fd = ::open(_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif // defined(_WIN32) || defined(__CYGWIN__)
+            if (_fd == invalid) throw std::system_error{errno, std::system_category(), "Failed to open " + _path};
+            _file_bytes = 0;
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+            struct stat info{};
+            if (::fstat(_fd, &info) == 0) _file_bytes = static_cast<size_t>(info.st_size);
+#endif // !defined(_WIN32) && !defined(__CYGWIN__)
+            _opened = std::chrono::steady_clock::now();
+        }
+
+        void close_file() {
+            if (_fd == invalid) return;
+#if defined(_WIN32) || defined(__CYGWIN__)
+            ::_close(_fd);
+#else
+            ::close(_fd);
+#endif // defined(_WIN32) || defined(__CYGWIN__)
+            _fd = invalid;
+        }
+
+        [[nodiscard]] std::string rotated_path() const {
+            auto separator = _path.find_last_of("/\\");
+            auto dot = _path.find_last_of('.');
+            if (dot == std::string::npos || (separator != std::string::npos && dot < separator)) dot = _path.size();
+            auto stem = _path.substr(0, dot);
+            auto extension = _path.substr(dot);
+
+            auto now = std::time(nullptr);
+            std::tm local{};
+#if defined(_WIN32) || defined(__CYGWIN__)
+            localtime_s(&local, &now);
+#else
+            localtime_r(&now, &local);
+#endif // defined(_WIN32) || defined(__CYGWIN__)
+            char suffix[32];
+            std::strftime(suffix, sizeof(suffix), ".%Y%m%d-%H%M%S", &local);
+
+            auto candidate = stem + suffix + extension;
+            for (int n = 1; file_exists(candidate) || file_exists(candidate + ".gz"); ++n) {
+                candidate = stem + suffix + "-" + std::to_string(n) + extension;
+            }
+            return candidate;
+        }
+
+        static bool file_exists(const std::string &path_) {
+            if (auto *file = std::fopen(path_.c_str(), "rb")) {
+                std::fclose(file);
+                return true;
+            }
+            return false;
+        }
+
+        static void compress_in_background(std::string path_) {
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+            std::thread([path = std::move(path_)] {
+                char gzip[] = "gzip";
+                char force[] = "-f";
+                char *argv[] = {gzip, force, const_cast<char *>(path.c_str()), nullptr};
+                pid_t pid;
+                if (posix_spawnp(&pid, "gzip", nullptr, nullptr, argv, environ) == 0) {
+                    int status;
+                    waitpid(pid, &status, 0);
+                }
+            }).detach();
+#endif // !defined(_WIN32) && !defined(__CYGWIN__)
+        }
+
+        static constexpr int invalid = -1;
+
+        std::string _path;
+        size_t _max_file_bytes;
+        std::chrono::seconds _max_file_age;
+        bool _compress_rotated;
+        size_t _buffer_bytes;
+        std::string _buffer;
+        io_uring_write_queue *_uring;
+        ///\brief Buffer of the write queued on _uring, until complete_queued_write()
+        std::string _queued;
+        io_uring_write_queue::request _queued_request;
+        bool _write_queued{false};
+        int _fd{invalid};
+        size_t _file_bytes{0};
+        std::chrono::steady_clock::time_point _opened;
+    };
+}
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif // !defined(_WIN32) && !defined(__CYGWIN__)
+
+namespace seq_logger {
+    ///\brief Memory-mapped ring of fixed-size event slots, which survives a crash of the process (the kernel keeps
+    /// the dirty pages of the file).
+    ///
+    /// File layout: header_size bytes of header (magic, version, slot size, slot count, next slot index), followed
+    /// by slot_count slots of slot_bytes. Event n goes to slot n % slot_count; a slot is the slot_header, the logger
+    /// name and the payload, truncated to the slot size. The payload is property_count spans (uint32 key offset into
+    /// the text, key length, value length), followed by the text, which starts with the message (message_length).
+    /// A slot is valid when begin == commit == n + 1: begin is stored before the slot is written, commit after.
+    struct flight_recorder_format {
+        static constexpr char magic[8] = {'S', 'E', 'Q', 'F', 'L', 'I', 'G', 'H'};
+        static constexpr uint32_t version = 1;
+        static constexpr size_t header_size = 64;
+
+        struct file_header {
+            char magic[8];
+            uint32_t version;
+            uint32_t slot_bytes;
+            uint64_t slot_count;
+            std::atomic<uint64_t> next;
+        };
+
+        struct slot_header {
+            std::atomic<uint64_t> begin;
+            std::atomic<uint64_t> commit;
+            int64_t timestamp_us;
+            uint8_t level;
+            uint8_t logger_length;
+            uint16_t reserved;
+            uint32_t message_length;
+            uint32_t property_count;
+            uint32_t payload_bytes;
+        };
+
+        static constexpr size_t span_bytes = 3 * sizeof(uint32_t);
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "The flight recorder needs lock-free 64 bit atomics");
+        static_assert(sizeof(file_header) <= header_size, "Flight recorder header too large");
+    };
+
+    ///\brief Writes events into a flight recorder file (see flight_recorder_format). record() only claims a slot with
+    /// an atomic increment and copies the event into it: it does not allocate or lock, so it is thread and
+    /// async-signal safe. An existing recording is kept as <path>.prev, so restarting after a crash does not overwrite it
+    class flight_recorder_writer {
+    public:
+        ///\param path_ File to map, created or replaced
+        ///\param slot_count_ Number of events kept, rounded up to a power of two
+        ///\param slot_bytes_ Size of a slot, larger events are truncated
+        flight_recorder_writer(std::string path_, size_t slot_count_, size_t slot_bytes_) : _path(std::move(path_)) {
+            if (slot_bytes_ < sizeof(flight_recorder_format::slot_header) + 64) {
+                throw std::invalid_argument("Flight recorder slots must be at least " +
+                                            std::to_string(sizeof(flight_recorder_format::slot_header) + 64) + " bytes");
+            }
+            _slot_bytes = (slot_bytes_ + 7) & ~size_t{7};
+            _slot_count = 1;
+            while (_slot_count < slot_count_) _slot_count <<= 1;
+            _size = flight_recorder_format::header_size + _slot_count * _slot_bytes;
+#if defined(_WIN32) || defined(__CYGWIN__)
+            throw std::runtime_error("The flight recorder is not supported on this platform");
+#else
+            keep_previous_recording();
+            int fd = ::open(_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) throw std::system_error{errno, std::system_category(), "Failed to open " + _path};
+            if (::ftruncate(fd, static_cast<off_t>(_size)) != 0) {
+                auto error = errno;
+                ::close(fd);
+                throw std::system_error{error, std::system_category(), "Failed to size " + _path};
+            }
+            int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+            // Fault the pages in up front rather than on the logging threads
+            flags |= MAP_POPULATE;
+#endif // MAP_POPULATE
+            void *memory = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, flags, fd, 0);
+            auto error = errno;
+            ::close(fd);
+            if (memory == MAP_FAILED) throw std::system_error{error, std::system_category(), "Failed to map " + _path};
+            _memory = static_cast<char *>(memory);
+
+            auto *header = new(_memory) flight_recorder_format::file_header{};
+            std::memcpy(header->magic, flight_recorder_format::magic, sizeof(header->magic));
+            header->version = flight_recorder_format::version;
+            header->slot_bytes = static_cast<uint32_t>(_slot_bytes);
+            header->slot_count = _slot_count;
+            _header = header;
+#endif // defined(_WIN32) || defined(__CYGWIN__)
+        }
+
+        ~flight_recorder_writer() {
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+            if (_memory != nullptr) ::munmap(_memory, _size);
+#endif // !defined(_WIN32) && !defined(__CYGWIN__)
+        }
+
+        flight_recorder_writer(flight_recorder_writer const &) = delete;
+
+        flight_recorder_writer &operator=(flight_recorder_writer const &) = delete;
+
+        ///\brief Copy an event into the next slot, see flight_recorder_format for the payload layout
+        void record(uint8_t level_, int64_t timestamp_us_, std::string_view logger_, uint32_t message_length_,
+                    uint32_t property_count_, const void *payload_, size_t payload_bytes_) noexcept {
+            auto index = _header->next.fetch_add(1, std::memory_order_relaxed);
+            auto *slot = _memory + flight_recorder_format::header_size + (index & (_slot_count - 1)) * _slot_bytes;
+            auto *header = reinterpret_cast<flight_recorder_format::slot_header *>(slot);
+            header->begin.store(index + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            auto capacity = _slot_bytes - sizeof(flight_recorder_format::slot_header);
+            auto logger_length = std::min({logger_.size(), size_t{255}, capacity});
+            auto payload_bytes = std::min(payload_bytes_, capacity - logger_length);
+            header->timestamp_us = timestamp_us_;
+            header->level = level_;
+            header->logger_length = static_cast<uint8_t>(logger_length);
+            header->message_length = message_length_;
+            header->property_count = property_count_;
+            header->payload_bytes = static_cast<uint32_t>(payload_bytes);
+            auto *data = slot + sizeof(flight_recorder_format::slot_header);
+            std::memcpy(data, logger_.data(), logger_length);
+            std::memcpy(data + logger_length, payload_, payload_bytes);
+
+            header->commit.store(index + 1, std::memory_order_release);
+        }
+
+        ///\brief Record an event without properties
+        void record(uint8_t level_, int64_t timestamp_us_, std::string_view logger_, std::string_view message_) noexcept {
+            record(level_, timestamp_us_, logger_, static_cast<uint32_t>(message_.size()), 0, message_.data(), message_.size());
+        }
+
+        [[nodiscard]] const std::string &path() const {
+            return _path;
+        }
+
+    private:
+        void keep_previous_recording() {
+            std::FILE *file = std::fopen(_path.c_str(), "rb");
+            if (file == nullptr) return;
+            char header[flight_recorder_format::header_size];
+            bool recorded = std::fread(header, 1, sizeof(header), file) == sizeof(header) &&
+                            std::memcmp(header, flight_recorder_format::magic, sizeof(flight_recorder_format::magic)) == 0;
+            std::fclose(file);
+            if (!recorded) return;
+            uint64_t next;
+            std::memcpy(&next, header + offsetof(flight_recorder_format::file_header, next), sizeof(next));
+            if (next > 0) std::rename(_path.c_str(), (_path + ".prev").c_str());
+        }
+
+        std::string _path;
+        size_t _slot_bytes{0};
+        size_t _slot_count{0};
+        size_t _size{0};
+        char *_memory{nullptr};
+        flight_recorder_format::file_header *_header{nullptr};
+    };
+
+    ///\brief Event read back from a flight recorder file
+    struct flight_recorder_event {
+        uint64_t index{0};
+        uint8_t level{0};
+        int64_t timestamp_us{0};
+        std::string_view logger;
+        std::string_view message;
+        std::vector<std::pair<std::string_view, std::string_view>> properties;
+        ///\brief Whether the event did not fit into its slot, message or properties are cut short then
+        bool truncated{false};
+    };
+
+    class flight_recorder_reader {
+    public:
+        ///\brief Decode the last last_ complete events of a flight recorder file, calling handler_ oldest first.
+        /// Slots that were being written when the process died are skipped
+        ///\return Number of decoded events
+        static size_t read_file(const std::string &path_, size_t last_,
+                                const std::function<void(const flight_recorder_event &)> &handler_) {
+            std::FILE *file = std::fopen(path_.c_str(), "rb");
+            if (file == nullptr) throw std::runtime_error("Failed to open " + path_);
+            std::string data;
+            char chunk[65536];
+            size_t read;
+            while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) data.append(chunk, read);
+            std::fclose(file);
+            return read_buffer(data, last_, handler_);
+        }
+
+        static size_t read_buffer(std::string_view data_, size_t last_,
+                                  const std::function<void(const flight_recorder_event &)> &handler_) {
+            using format = flight_recorder_format;
+            if (data_.size() < format::header_size || std::memcmp(data_.data(), format::magic, sizeof(format::magic)) != 0) {
+                throw std::runtime_error("Not a flight recorder file");
+            }
+            uint32_t version, slot_bytes;
+            uint64_t slot_count, next;
+            std::memcpy(&version, data_.data() + offsetof(format::file_header, version), sizeof(version));
+            std::memcpy(&slot_bytes, data_.data() + offsetof(format::file_header, slot_bytes), sizeof(slot_bytes));
+            std::memcpy(&slot_count, data_.data() + offsetof(format::file_header, slot_count), sizeof(slot_count));
+            std::memcpy(&next, data_.data() + offsetof(format::file_header, next), sizeof(next));
+            if (version != format::version) throw std::runtime_error("Unsupported flight recorder version");
+            if (slot_bytes < sizeof(format::slot_header) || slot_count == 0 || (slot_count & (slot_count - 1)) != 0 ||
+                (data_.size() - format::header_size) / slot_bytes < slot_count) {
+                throw std::runtime_error("Corrupted flight recorder header");
+            }
+
+            // Newest first, so that only the slots needed are decoded
+            std::vector<flight_recorder_event> events;
+            for (uint64_t index = next; index > 0 && next - index < slot_count && events.size() < last_; --index) {
+                flight_recorder_event event;
+                if (decode(data_.substr(format::header_size + ((index - 1) & (slot_count - 1)) * slot_bytes, slot_bytes),
+                           index - 1, event)) {
+                    events.push_back(std::move(event));
+                }
+            }
+            for (auto it = events.rbegin(); it != events.rend(); ++it) handler_(*it);
+            return events.size();
+        }
+
+    private:
+        static bool decode(std::string_view slot_, uint64_t index_, flight_recorder_event &event_) {
+            using format = flight_recorder_format;
+            uint64_t begin, commit;
+            std::memcpy(&begin, slot_.data() + offsetof(format::slot_header, begin), sizeof(begin));
+            std::memcpy(&commit, slot_.data() + offsetof(format::slot_header, commit), sizeof(commit));
+            if (begin != index_ + 1 || commit != index_ + 1) return false;
+
+            uint8_t logger_length;
+            uint32_t message_length, property_count, payload_bytes;
+            std::memcpy(&event_.timestamp_us, slot_.data() + offsetof(format::slot_header, timestamp_us), sizeof(int64_t));
+            std::memcpy(&event_.level, slot_.data() + offsetof(format::slot_header, level), 1);
+            std::memcpy(&logger_length, slot_.data() + offsetof(format::slot_header, logger_length), 1);
+            std::memcpy(&message_length, slot_.data() + offsetof(format::slot_header, message_length), 4);
+            std::memcpy(&property_count, slot_.data() + offsetof(format::slot_header, property_count), 4);
+            std::memcpy(&payload_bytes, slot_.data() + offsetof(format::slot_header, payload_bytes), 4);
+            auto data = slot_.substr(sizeof(format::slot_header));
+            if (logger_length + size_t{payload_bytes} > data.size()) return false;
+            event_.index = index_;
+            event_.logger = data.substr(0, logger_length);
+            auto payload = data.substr(logger_length, payload_bytes);
+
+            size_t spans_bytes = size_t{property_count} * format::span_bytes;
+            if (spans_bytes > payload.size()) {
+                event_.truncated = true;
+                return true;
+            }
+            auto text = payload.substr(spans_bytes);
+            event_.message = text.substr(0, message_length);
+            event_.truncated = event_.message.size() < message_length;
+            for (uint32_t i = 0; i < property_count; ++i) {
+                uint32_t span[3];
+                std::memcpy(span, payload.data() + i * format::span_bytes, sizeof(span));
+                if (size_t{span[0]} + span[1] + span[2] > text.size()) {
+                    event_.truncated = true;
+                    break;
+                }
+                event_.properties.emplace_back(text.substr(span[0], span[1]), text.substr(span[0] + span[1], span[2]));
+            }
+            return true;
+        }
+    };
+}
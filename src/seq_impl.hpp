@@ -0,0 +1,712 @@
+#pragma once
+
+// Definitions of the non-template parts of seq.hpp that need the HTTP client, file outputs or iostreams. Included at
+// the end of seq.hpp (header-only), or compiled once by src/seq.cpp when SEQ_LOGGER_COMPILED_LIB is defined
+
+#include <cstdlib>
+#include <iostream>
+#include <shared_mutex>
+#include <sstream>
+#include <thread>
+
+#include "seq.hpp"
+#include "seq_config.hpp"
+#include "seq_flight_recorder.hpp"
+#include "seq_sinks.hpp"
+#include "seq_thread.hpp"
+#include "seq_uring.hpp"
+
+#ifdef SEQ_LOGGER_HAS_TSC
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif // defined(_MSC_VER)
+#endif // SEQ_LOGGER_HAS_TSC
+
+namespace seq_logger {
+    SEQ_LOGGER_INLINE std::vector<seq_level_rule> parse_level_rules(std::string_view text_, std::string_view origin_) {
+        auto trim = [](std::string_view value_) {
+            while (!value_.empty() && std::isspace(static_cast<unsigned char>(value_.front()))) value_.remove_prefix(1);
+            while (!value_.empty() && std::isspace(static_cast<unsigned char>(value_.back()))) value_.remove_suffix(1);
+            return value_;
+        };
+        std::vector<seq_level_rule> rules;
+        while (!text_.empty()) {
+            auto end = text_.find_first_of(";\n");
+            auto line = text_.substr(0, end);
+            text_.remove_prefix(end == std::string_view::npos ? text_.size() : end + 1);
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty()) continue;
+
+            auto equals = line.find('=');
+            auto levels = equals == std::string_view::npos ? std::string_view() : line.substr(equals + 1);
+            auto comma = levels.find(',');
+            auto pattern = trim(line.substr(0, equals));
+            auto console = trim(levels.substr(0, comma));
+            auto seq = comma == std::string_view::npos ? console : trim(levels.substr(comma + 1));
+            logging_level console_level, seq_level;
+            if (pattern.empty() || !try_parse_logging_level(console, console_level) || !try_parse_logging_level(seq, seq_level)) {
+                std::cerr << origin_ << ": ignoring invalid level rule '" << line << "'" << std::endl;
+                continue;
+            }
+            rules.push_back({std::string(pattern), console_level, seq_level});
+        }
+        return rules;
+    }
+
+    SEQ_LOGGER_INLINE void seq_sink::report_error(const std::exception &e_) {
+        // A sink failing on every batch (e.g. while Seq is down) must not flood stderr
+        static std::mutex mutex;
+        static bool reported(false);
+        static std::chrono::steady_clock::time_point last_reported;
+        static uint64_t suppressed = 0;
+        std::lock_guard<std::mutex> guard(mutex);
+        auto now = std::chrono::steady_clock::now();
+        if (reported && now - last_reported < std::chrono::seconds(1)) {
+            ++suppressed;
+            return;
+        }
+        reported = true;
+        last_reported = now;
+        std::cerr << "Error in log sink: " << e_.what();
+        if (suppressed > 0) std::cerr << " (" << suppressed << " more errors since the last report)";
+        std::cerr << std::endl;
+        suppressed = 0;
+    }
+
+    SEQ_LOGGER_INLINE bool seq_clock::use(clock_source source_) {
+        if (source_ == clock_source::system) {
+            _source.store(clock_source::system, std::memory_order_relaxed);
+            return true;
+        }
+#ifdef SEQ_LOGGER_HAS_TSC
+        if (!has_invariant_tsc()) return false;
+        std::lock_guard<std::mutex> guard(_calibration_mutex);
+        auto tsc_start = read_tsc();
+        auto ns_start = system_ns();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        auto tsc_end = read_tsc();
+        auto ns_end = system_ns();
+        if (tsc_end <= tsc_start) return false;
+        store_calibration(tsc_end, ns_end, static_cast<double>(ns_end - ns_start) / static_cast<double>(tsc_end - tsc_start));
+        _last_sync_tsc = tsc_end;
+        _last_sync_ns = ns_end;
+        _source.store(clock_source::tsc, std::memory_order_relaxed);
+        return true;
+#else
+        return false;
+#endif // SEQ_LOGGER_HAS_TSC
+    }
+
+    SEQ_LOGGER_INLINE void seq_clock::calibrate() {
+#ifdef SEQ_LOGGER_HAS_TSC
+        if (_source.load(std::memory_order_relaxed) != clock_source::tsc) return;
+        std::lock_guard<std::mutex> guard(_calibration_mutex);
+        auto tsc = read_tsc();
+        auto ns = system_ns();
+        if (tsc <= _last_sync_tsc || ns - _last_sync_ns < 1000000000) return;
+
+        auto ticks = static_cast<double>(tsc - _last_sync_tsc);
+        auto measured = static_cast<double>(ns - _last_sync_ns) / ticks;
+        auto derived = from_tsc(tsc);
+        auto error = ns - derived;
+        if (std::llabs(error) > 1000000000) {
+            store_calibration(tsc, ns, measured);
+        } else {
+            auto rate = measured + static_cast<double>(error) / ticks;
+            store_calibration(tsc, derived, std::min(std::max(rate, measured * 0.5), measured * 2));
+        }
+        _last_sync_tsc = tsc;
+        _last_sync_ns = ns;
+#endif // SEQ_LOGGER_HAS_TSC
+    }
+
+#ifdef SEQ_LOGGER_HAS_TSC
+    SEQ_LOGGER_INLINE bool seq_clock::has_invariant_tsc() {
+#if defined(_MSC_VER)
+        int registers[4];
+        __cpuid(registers, 0x80000000);
+        if (static_cast<unsigned>(registers[0]) < 0x80000007u) return false;
+        __cpuid(registers, 0x80000007);
+        return (registers[3] & (1 << 8)) != 0;
+#else
+        unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (__get_cpuid_max(0x80000000u, nullptr) < 0x80000007u) return false;
+        if (__get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx) == 0) return false;
+        return (edx & (1u << 8)) != 0;
+#endif // defined(_MSC_VER)
+    }
+#endif // SEQ_LOGGER_HAS_TSC
+
+    SEQ_LOGGER_INLINE void seq_log_entry::record_to(flight_recorder_writer &recorder_) const noexcept {
+        static_assert(sizeof(span) == flight_recorder_format::span_bytes, "Spans are copied as flight recorder payload");
+        recorder_.record(static_cast<uint8_t>(level),
+                         std::chrono::duration_cast<std::chrono::microseconds>(timestamp.time_since_epoch()).count(),
+                         logger_name, _message_length, _property_count, spans(),
+                         _property_count * sizeof(span) + _text_bytes);
+    }
+
+    SEQ_LOGGER_INLINE void seq_sink_worker::run() {
+        in_logger_thread() = true;
+        static std::atomic<int> workers_started{0};
+        auto errors = apply_thread_options(_thread_options, "-sink" + std::to_string(++workers_started));
+        if (!errors.empty()) seq_sink::report_error(std::runtime_error("Sink thread options not applied: " + errors));
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (;;) {
+            _wake.wait(lock, [this] { return _stopping || !_pending.empty(); });
+            if (_pending.empty()) return;
+            auto batch = std::move(_pending.front());
+            _pending.pop_front();
+            _writing = true;
+            lock.unlock();
+            _sink->write_batch(batch->entries);
+            if (auto *uring = io_uring_write_queue::existing()) uring->submit();
+            batch.reset();
+            lock.lock();
+            _writing = false;
+            if (_pending.empty()) _idle.notify_all();
+        }
+    }
+
+    SEQ_LOGGER_INLINE void console_sink::write(const seq_log_entry &entry_) {
+        static const char esc_char = 27;
+        std::stringstream ss;
+        ss << entry_.time() << "\t" << entry_.logger_name << "\t["
+           << logging_level_strings_short[entry_.level] << "]\t" << esc_char << "[1m"
+           << entry_.message() << esc_char
+           << "[0m\t\t";
+        for (size_t i = 0; i < entry_.property_count(); ++i) {
+            auto property = entry_.property(i);
+            ss << property.key << "=" << property.value << " ";
+        }
+        ss << std::endl;
+        if (entry_.level > logging_level::warning) {
+            std::cerr << ss.str();
+            std::cerr.flush();
+        } else {
+            std::cout << ss.str();
+            std::cout.flush();
+        }
+    }
+
+    SEQ_LOGGER_INLINE std::shared_ptr<binary_file_sink> seq::enable_binary_file_output(std::string directory_, std::string prefix_, size_t max_segment_bytes_) {
+        auto sink = std::make_shared<binary_file_sink>(std::move(directory_), std::move(prefix_), max_segment_bytes_);
+        add_sink(sink, sink_mode::dispatcher);
+        return sink;
+    }
+
+    SEQ_LOGGER_INLINE std::shared_ptr<clef_file_sink> seq::enable_clef_file_output(std::string path_, size_t max_file_bytes_, std::chrono::seconds max_file_age_, bool compress_rotated_, file_write_backend backend_) {
+        auto sink = std::make_shared<clef_file_sink>(std::move(path_), max_file_bytes_, max_file_age_, compress_rotated_,
+                                                     logging_level::verbose, backend_);
+        add_sink(sink, sink_mode::dispatcher);
+        return sink;
+    }
+
+    SEQ_LOGGER_INLINE void seq::add_sink(std::shared_ptr<seq_sink> sink_, sink_mode mode_, size_t max_pending_batches_) {
+        sink_slot slot{sink_, mode_, std::make_shared<std::mutex>(), nullptr};
+        std::lock_guard<std::mutex> guard(_s_sinks_mutex);
+        if (mode_ == sink_mode::own_thread) {
+            slot.worker = std::make_shared<seq_sink_worker>(sink_, max_pending_batches_, _s_thread_options);
+        }
+        auto sinks = std::make_shared<sinks_t>(*current_sinks());
+        sinks->push_back(std::move(slot));
+        std::atomic_store(&sinks_storage(), std::shared_ptr<const sinks_t>(std::move(sinks)));
+        update_dispatch_floor();
+    }
+
+    SEQ_LOGGER_INLINE void seq::remove_sink(const std::shared_ptr<seq_sink> &sink_) {
+        std::shared_ptr<seq_sink_worker> worker;
+        {
+            std::lock_guard<std::mutex> guard(_s_sinks_mutex);
+            auto sinks = std::make_shared<sinks_t>(*current_sinks());
+            auto pos = std::find_if(sinks->begin(), sinks->end(), [&](const sink_slot &slot_) {
+                return slot_.sink == sink_;
+            });
+            if (pos == sinks->end()) return;
+            worker = pos->worker;
+            sinks->erase(pos);
+            std::atomic_store(&sinks_storage(), std::shared_ptr<const sinks_t>(std::move(sinks)));
+            update_dispatch_floor();
+        }
+        if (worker) worker->stop();
+    }
+
+    SEQ_LOGGER_INLINE uint64_t seq::stop_sink_workers(std::chrono::steady_clock::time_point deadline_) {
+        uint64_t dropped = 0;
+        auto sinks = current_sinks();
+        for (const auto &slot: *sinks) {
+            if (slot.worker) dropped += slot.worker->stop(deadline_);
+        }
+        return dropped;
+    }
+
+    struct seq::registry_shard {
+        std::shared_mutex mutex;
+        std::unordered_map<std::string_view, std::shared_ptr<seq>> loggers;
+    };
+
+    SEQ_LOGGER_INLINE seq::registry_shard &seq::registry_shard_for(std::string_view name_) {
+        static constexpr size_t shard_count = 16;
+        static registry_shard shards[shard_count];
+        return shards[std::hash<std::string_view>{}(name_) % shard_count];
+    }
+
+    SEQ_LOGGER_INLINE std::shared_ptr<seq> seq::get(std::string_view name_) {
+        // The registry must be destroyed before the shared instance, which receives the logs of destroyed loggers
+        (void) shared_instance();
+        auto &shard = registry_shard_for(name_);
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto found = shard.loggers.find(name_);
+            if (found != shard.loggers.end()) return found->second;
+        }
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto found = shard.loggers.find(name_);
+        if (found != shard.loggers.end()) return found->second;
+        auto console_verbosity = base_level_console.load();
+        auto seq_verbosity = base_level_seq.load();
+        find_level_rule(name_, console_verbosity, seq_verbosity);
+        auto logger = std::make_shared<seq>(std::string(name_).c_str(), console_verbosity, seq_verbosity);
+        // Keyed by the name owned by the logger, so lookups do not allocate
+        shard.loggers.emplace(logger->_name, logger);
+        return logger;
+    }
+
+    SEQ_LOGGER_INLINE bool seq::release(std::string_view name_) {
+        auto &shard = registry_shard_for(name_);
+        std::shared_ptr<seq> logger;
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            auto found = shard.loggers.find(name_);
+            if (found == shard.loggers.end()) return false;
+            // The key points into the logger, which is kept until after the erase and destroyed without the lock
+            logger = std::move(found->second);
+            shard.loggers.erase(found);
+        }
+        return true;
+    }
+
+    struct seq::level_config_watch {
+        ///\brief Guarded by _s_level_config_mutex, replaced only while thread is not running
+        std::unique_ptr<config_file_watcher> watcher;
+        ///\brief Serializes starting and stopping thread
+        std::mutex thread_mutex;
+        std::thread thread;
+
+        ~level_config_watch() {
+            std::lock_guard<std::mutex> guard(thread_mutex);
+            stop();
+        }
+
+        ///\brief Requires thread_mutex
+        void stop() {
+            if (!thread.joinable()) return;
+            {
+                std::lock_guard<std::mutex> guard(_s_level_config_mutex);
+                watcher->interrupt();
+            }
+            thread.join();
+        }
+    };
+
+    SEQ_LOGGER_INLINE seq::level_config_watch &seq::level_config_watching() {
+        static level_config_watch watch;
+        return watch;
+    }
+
+    SEQ_LOGGER_INLINE void seq::level_config_loop(config_file_watcher *watcher_) {
+        seq_thread_options thread_options;
+        {
+            std::lock_guard<std::mutex> guard(_s_sinks_mutex);
+            thread_options = _s_thread_options;
+        }
+        auto thread_errors = apply_thread_options(thread_options, "-config");
+        if (!thread_errors.empty()) log_warning("Config thread options not applied: {Errors}", {{"Errors", thread_errors}});
+        // Without inotify the modification time is checked once per second
+        while (watcher_->wait(std::chrono::seconds(1))) {
+            std::lock_guard<std::mutex> guard(_s_level_config_mutex);
+            poll_level_config();
+        }
+    }
+
+    SEQ_LOGGER_INLINE void seq::watch_level_config(std::string path_) {
+        // Loggers registered by the shared instance must outlive the thread, which is stopped at exit
+        (void) shared_instance();
+        auto &watch = level_config_watching();
+        std::lock_guard<std::mutex> thread_guard(watch.thread_mutex);
+        watch.stop();
+        config_file_watcher *watcher;
+        {
+            std::lock_guard<std::mutex> guard(_s_level_config_mutex);
+            watch.watcher = std::make_unique<config_file_watcher>(std::move(path_));
+            watcher = watch.watcher.get();
+            poll_level_config();
+        }
+        watch.thread = std::thread(&seq::level_config_loop, watcher);
+    }
+
+    SEQ_LOGGER_INLINE void seq::set_level_config(std::string_view rules_) {
+        auto &watch = level_config_watching();
+        std::lock_guard<std::mutex> thread_guard(watch.thread_mutex);
+        watch.stop();
+        std::lock_guard<std::mutex> guard(_s_level_config_mutex);
+        watch.watcher.reset();
+        _s_config_level_rules = parse_level_rules(rules_, "seq_logger");
+        apply_level_config_to_all();
+    }
+
+    SEQ_LOGGER_INLINE void seq::enable_flight_recorder(std::string path_, size_t slot_count_, size_t slot_bytes_) {
+        std::lock_guard<std::mutex> guard(_s_sinks_mutex);
+        if (_s_flight_recorder.load(std::memory_order_relaxed) != nullptr) return;
+        // Never destroyed: logging threads and signal handlers may use it until the very end
+        _s_flight_recorder.store(new flight_recorder_writer(std::move(path_), slot_count_, slot_bytes_),
+                                 std::memory_order_release);
+    }
+
+    SEQ_LOGGER_INLINE void seq::flight_record(logging_level level_, std::string_view message_) noexcept {
+        auto *recorder = _s_flight_recorder.load(std::memory_order_acquire);
+        if (recorder == nullptr) return;
+        recorder->record(static_cast<uint8_t>(level_), std::chrono::duration_cast<std::chrono::microseconds>(
+                seq_clock::now().time_since_epoch()).count(), "Default", message_);
+    }
+
+    SEQ_LOGGER_INLINE std::vector<seq_log_entry *> seq::take_queued(bool priority_) {
+        std::vector<std::vector<seq_log_entry *>> queues;
+        {
+            std::lock_guard<std::mutex> static_guard(_s_loggers_mutex);
+            for (auto *logger: _s_loggers) {
+                std::lock_guard<std::mutex> guard(logger->_logs_mutex);
+                auto &queue = priority_ ? logger->_seq_priority_queue : logger->_seq_dispatch_queue;
+                if (queue.empty()) continue;
+                queues.emplace_back().swap(queue);
+            }
+        }
+        return merge_by_sequence(queues);
+    }
+
+    SEQ_LOGGER_INLINE size_t seq::dispatch_events(bool priority_only_) {
+        auto flush_start = std::chrono::steady_clock::now();
+        update_dispatch_floor();
+        // Cleared before taking the lanes: priority events queued from now on wake the dispatcher again
+        _s_priority_pending.store(false, std::memory_order_relaxed);
+        std::shared_ptr<const seq_log_batch> batches[2];
+        size_t events = 0;
+        for (bool priority: {true, false}) {
+            if (!priority && priority_only_) break;
+            auto entries = take_queued(priority);
+            if (entries.empty()) continue;
+            events += entries.size();
+            batches[priority ? 0 : 1] = std::make_shared<const seq_log_batch>(std::move(entries), priority);
+        }
+        if (events == 0) return 0;
+
+        metrics().events_dequeued(events);
+        auto sinks = current_sinks();
+        for (const auto &batch: batches) {
+            if (!batch) continue;
+            for (const auto &slot: *sinks) {
+                if (slot.mode == sink_mode::dispatcher) {
+                    slot.sink->write_batch(batch->entries);
+                } else if (slot.mode == sink_mode::own_thread) {
+                    slot.worker->push(batch);
+                }
+            }
+            // File writes queued by the sinks above go to the kernel together
+            if (auto *uring = io_uring_write_queue::existing()) uring->submit();
+        }
+        metrics().flushed(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - flush_start));
+        return events;
+    }
+
+    SEQ_LOGGER_INLINE seq_flush_result seq::flush(std::chrono::steady_clock::time_point deadline_) {
+        seq_flush_result result;
+        std::unique_lock<std::timed_mutex> dispatch_lock(_s_dispatch_mutex, std::defer_lock);
+        if (!dispatch_lock.try_lock_until(deadline_)) {
+            result.pending = metrics().snapshot().queue_depth;
+            return result;
+        }
+        auto dropped_before = metrics().snapshot().events_dropped;
+        _s_flush_deadline_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                deadline_.time_since_epoch()).count(), std::memory_order_relaxed);
+
+        auto logger_thread = std::exchange(in_logger_thread(), true);
+        auto dispatched = dispatch_events();
+        in_logger_thread() = logger_thread;
+        auto sinks = current_sinks();
+        for (const auto &slot: *sinks) {
+            if (slot.worker) slot.worker->wait_idle(deadline_);
+        }
+        if (auto *uring = io_uring_write_queue::existing()) uring->wait_all();
+
+        _s_flush_deadline_ns.store(0, std::memory_order_relaxed);
+        auto after = metrics().snapshot();
+        result.dropped = after.events_dropped - dropped_before;
+        result.delivered = dispatched > result.dropped ? dispatched - result.dropped : 0;
+        result.pending = after.queue_depth;
+        for (const auto &slot: *sinks) {
+            if (slot.worker) result.pending += slot.worker->pending_events();
+        }
+        return result;
+    }
+
+    SEQ_LOGGER_INLINE std::future<seq_flush_result> seq::flush_async(std::chrono::milliseconds timeout_) {
+        auto deadline = std::chrono::steady_clock::now() + timeout_;
+        return std::async(std::launch::async, [deadline] { return flush(deadline); });
+    }
+
+    SEQ_LOGGER_INLINE seq_flush_result seq::shutdown(std::chrono::steady_clock::time_point deadline_) {
+        {
+            std::unique_lock<std::mutex> lock{_s_thread_finished_mutex};
+            _s_terminating = true;
+            _s_dispatcher_wake.notify_all();
+            // The dispatcher may still be probing Seq or blocked in a sink, in which case it is left behind
+            _s_thread_finished.wait_until(lock, deadline_, [] { return !_s_thread_running || _s_thread_exited; });
+        }
+        auto result = flush(deadline_);
+        auto dropped = stop_sink_workers(deadline_);
+        if (auto *uring = io_uring_write_queue::existing()) uring->wait_all();
+        result.dropped += dropped;
+        result.pending = result.pending > dropped ? result.pending - dropped : 0;
+        return result;
+    }
+
+    SEQ_LOGGER_INLINE size_t seq::drop_oldest_queued(size_t bytes_) {
+        size_t dropped = 0;
+        size_t released = 0;
+        {
+            // Every queue stays locked while the oldest events are picked by sequence; like the dispatcher, queues
+            // are locked in _s_loggers order under _s_loggers_mutex
+            std::lock_guard<std::mutex> static_guard(_s_loggers_mutex);
+            std::vector<std::unique_lock<std::mutex>> guards;
+            std::vector<std::vector<seq_log_entry *> *> queues;
+            guards.reserve(_s_loggers.size());
+            queues.reserve(_s_loggers.size());
+            size_t queued = 0;
+            for (auto *logger: _s_loggers) {
+                guards.emplace_back(logger->_logs_mutex);
+                queues.push_back(&logger->_seq_dispatch_queue);
+                queued += logger->_seq_dispatch_queue.size();
+            }
+
+            // Drop a sixteenth of the queued events at least, so a full budget does not shift the queues for every event
+            auto min_dropped = queued / 16 + 1;
+            std::vector<size_t> taken(queues.size(), 0);
+            while (dropped < queued && (released < bytes_ || dropped < min_dropped)) {
+                size_t oldest = queues.size();
+                for (size_t i = 0; i < queues.size(); ++i) {
+                    if (taken[i] == queues[i]->size()) continue;
+                    if (oldest == queues.size() ||
+                        (*queues[i])[taken[i]]->sequence < (*queues[oldest])[taken[oldest]]->sequence) {
+                        oldest = i;
+                    }
+                }
+                auto *entry = (*queues[oldest])[taken[oldest]++];
+                released += entry->budget_bytes;
+                delete entry;
+                ++dropped;
+            }
+            for (size_t i = 0; i < queues.size(); ++i) {
+                queues[i]->erase(queues[i]->begin(), queues[i]->begin() + static_cast<std::ptrdiff_t>(taken[i]));
+            }
+        }
+        seq_memory_budget::instance().release(released);
+        metrics().events_dequeued(dropped);
+        metrics().events_over_budget(dropped);
+        return dropped;
+    }
+
+    SEQ_LOGGER_INLINE std::vector<seq_log_entry *> seq::merge_by_sequence(std::vector<std::vector<seq_log_entry *>> &queues_) {
+        if (queues_.empty()) return {};
+        if (queues_.size() == 1) return std::move(queues_.front());
+
+        size_t total = 0;
+        for (const auto &queue: queues_) total += queue.size();
+        std::vector<seq_log_entry *> merged;
+        merged.reserve(total);
+
+        // Min-heap of (queue, position) cursors ordered by the sequence number they point to
+        std::vector<std::pair<size_t, size_t>> heads;
+        heads.reserve(queues_.size());
+        for (size_t i = 0; i < queues_.size(); ++i) heads.emplace_back(i, 0);
+        auto later = [&](const std::pair<size_t, size_t> &l_, const std::pair<size_t, size_t> &r_) {
+            return queues_[l_.first][l_.second]->sequence > queues_[r_.first][r_.second]->sequence;
+        };
+        std::make_heap(heads.begin(), heads.end(), later);
+        while (!heads.empty()) {
+            std::pop_heap(heads.begin(), heads.end(), later);
+            auto &head = heads.back();
+            merged.push_back(queues_[head.first][head.second]);
+            if (++head.second < queues_[head.first].size()) {
+                std::push_heap(heads.begin(), heads.end(), later);
+            } else {
+                heads.pop_back();
+            }
+        }
+        return merged;
+    }
+
+    SEQ_LOGGER_INLINE void seq::emit_self_monitoring_event(std::chrono::steady_clock::time_point &last_emitted_,
+                                                           seq_sink &seq_sink_) {
+        auto interval = std::chrono::milliseconds(_s_self_monitoring_interval_ms.load(std::memory_order_relaxed));
+        auto now = std::chrono::steady_clock::now();
+        if (interval.count() <= 0 || now - last_emitted_ < interval) return;
+        last_emitted_ = now;
+
+        auto snapshot = stats();
+        seq_properties_vector_t properties{
+                {"EventsEnqueued",      snapshot.total_enqueued()},
+                {"EventsDropped",       snapshot.events_dropped},
+                {"EventsFiltered",      snapshot.events_filtered},
+                {"EventsOverBudget",    snapshot.events_over_budget},
+                {"EventsTruncated",     snapshot.events_truncated},
+                {"BudgetBytesUsed",     snapshot.budget_bytes_used},
+                {"QueueDepth",          snapshot.queue_depth},
+                {"BytesSerialized",     snapshot.bytes_serialized},
+                {"BytesSent",           snapshot.bytes_sent},
+                {"Flushes",             snapshot.flushes},
+                {"FlushDurationP99Us",  snapshot.flush_duration.percentile(0.99)},
+                {"HttpRequests",        snapshot.http_requests},
+                {"HttpFailures",        snapshot.http_failures},
+                {"HttpLatencyP50Us",    snapshot.http_latency.percentile(0.5)},
+                {"HttpLatencyP99Us",    snapshot.http_latency.percentile(0.99)}
+        };
+        for (int level = logging_level::verbose; level <= logging_level::fatal; ++level) {
+            properties.emplace_back(std::string("EventsEnqueued") + logging_level_strings[level], snapshot.events_enqueued[level]);
+        }
+        std::unique_ptr<seq_log_entry> entry(seq_log_entry::create(
+                "Logger statistics: {EventsEnqueued} enqueued, {EventsDropped} dropped, {QueueDepth} queued",
+                seq_context(logging_level::info, std::move(properties), "SeqLogger")));
+        seq_sink_.write_batch({entry.get()});
+    }
+
+    SEQ_LOGGER_INLINE void seq::update_server_level_seq(std::string_view body_) {
+        static constexpr std::string_view key = "\"MinimumLevelAccepted\"";
+        auto pos = body_.find(key);
+        if (pos == std::string_view::npos) return;
+        pos = body_.find_first_not_of(" \t\r\n:", pos + key.size());
+        if (pos == std::string_view::npos) return;
+        logging_level level = logging_level::verbose;
+        if (body_[pos] == '"') {
+            auto end = body_.find('"', pos + 1);
+            if (end == std::string_view::npos) return;
+            level = parse_logging_level(body_.substr(pos + 1, end - pos - 1), logging_level::verbose);
+        }
+        _s_server_level_seq.store(level, std::memory_order_relaxed);
+        update_dispatch_floor();
+    }
+
+    SEQ_LOGGER_INLINE void seq::send_events_loop_handler(int timeout, bool allow_without_seq) {
+        in_logger_thread() = true;
+        // Before anything is allocated on this thread (the Seq sink, batches), so that it lands on the local NUMA node
+        seq_thread_options thread_options;
+        {
+            std::lock_guard<std::mutex> guard(_s_sinks_mutex);
+            thread_options = _s_thread_options;
+        }
+        auto thread_errors = apply_thread_options(thread_options, "-dispatch");
+        if (!thread_errors.empty()) log_warning("Dispatcher thread options not applied: {Errors}", {{"Errors", thread_errors}});
+
+        // The Seq sink is added right away, so that events logged meanwhile are queued for it (and not filtered by the
+        // levels of other sinks). Nothing is dispatched before the health check completed
+        std::shared_ptr<seq_http_sink> http_sink;
+        bool seq_ready(_s_addresses.empty());
+        if (!seq_ready) {
+            http_sink = std::make_shared<seq_http_sink>(_s_addresses, _s_auth_header, _s_endpoint_selection);
+            add_sink(http_sink, sink_mode::dispatcher);
+            seq_ready = http_sink->check_health(std::chrono::milliseconds(timeout));
+            if (!seq_ready) {
+                remove_sink(http_sink);
+                log_warning("Seq ingestion not ready");
+            }
+        }
+
+        if (!seq_ready) {
+            if (allow_without_seq){
+                log_info("Seq failed to initialize, but working without it is allowed. Only using console output.");
+            } else {
+                {
+                    std::unique_lock<std::mutex> lock{_s_thread_finished_mutex};
+                    _s_terminating = true;
+                    _s_thread_exited = true;
+                    _s_thread_finished.notify_all();
+                }
+                signal_ready(false);
+                return;
+            }
+        }
+
+        signal_ready(seq_ready);
+
+        auto self_monitoring_emitted = std::chrono::steady_clock::now();
+        auto next_dispatch = self_monitoring_emitted + _s_dispatch_interval;
+        std::unique_lock<std::mutex> lock{_s_thread_finished_mutex};
+        while (!_s_terminating) {
+            // Priority events are dispatched as soon as they are queued, everything else once per interval
+            _s_dispatcher_wake.wait_until(lock, next_dispatch, [] {
+                return _s_terminating || _s_priority_pending.load(std::memory_order_relaxed);
+            });
+            // What is queued when terminating is dispatched by shutdown()
+            if (_s_terminating) break;
+            bool interval_elapsed = std::chrono::steady_clock::now() >= next_dispatch;
+            lock.unlock();
+            if (interval_elapsed) seq_clock::calibrate();
+            {
+                std::lock_guard<std::timed_mutex> guard(_s_dispatch_mutex);
+                dispatch_events(!interval_elapsed);
+                if (interval_elapsed && http_sink && seq_ready) emit_self_monitoring_event(self_monitoring_emitted, *http_sink);
+            }
+            if (interval_elapsed) next_dispatch = std::chrono::steady_clock::now() + _s_dispatch_interval;
+            lock.lock();
+        }
+
+        _s_thread_exited = true;
+        _s_thread_finished.notify_all();
+    }
+
+    SEQ_LOGGER_INLINE void seq::start_thread(int timeout, bool allow_without_seq) {
+        if (!_static_instance) return;
+        {
+            std::unique_lock<std::mutex> lock{_s_thread_finished_mutex};
+            _s_thread_running = true;
+        }
+        std::thread(&seq::send_events_loop_handler, timeout, allow_without_seq).detach();
+    }
+
+    SEQ_LOGGER_INLINE void seq::apply_level_config_locked(seq &logger_) {
+        if (!_s_env_level_rules_loaded) {
+            _s_env_level_rules_loaded = true;
+            if (const char *rules = std::getenv("SEQ_LOGGER_LEVELS")) {
+                _s_env_level_rules = parse_level_rules(rules, "SEQ_LOGGER_LEVELS");
+            }
+        }
+        const seq_level_rule *match = nullptr;
+        for (const auto *rules: {&_s_env_level_rules, &_s_config_level_rules}) {
+            for (const auto &rule: *rules) {
+                if (glob_match(rule.pattern, logger_._name)) match = &rule;
+            }
+        }
+
+        if (match != nullptr) {
+            if (!logger_._levels_from_config.exchange(true)) {
+                logger_._level_console_before_config = logger_.level_console.load(std::memory_order_relaxed);
+                logger_._level_seq_before_config = logger_.level_seq.load(std::memory_order_relaxed);
+            }
+            logger_.level_console.store(match->console, std::memory_order_relaxed);
+            logger_.level_seq.store(match->seq, std::memory_order_relaxed);
+        } else if (logger_._levels_from_config.exchange(false)) {
+            logger_.level_console.store(logger_._level_console_before_config, std::memory_order_relaxed);
+            logger_.level_seq.store(logger_._level_seq_before_config, std::memory_order_relaxed);
+        }
+    }
+
+    SEQ_LOGGER_INLINE void seq::poll_level_config() {
+        auto &watcher = level_config_watching().watcher;
+        if (!watcher || !watcher->changed()) return;
+        std::string content;
+        if (!read_text_file(watcher->path(), content)) return;
+        _s_config_level_rules = parse_level_rules(content, watcher->path());
+        apply_level_config_to_all();
+    }
+}
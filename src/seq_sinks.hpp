@@ -0,0 +1,571 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "HTTPRequest.hpp"
+#include "seq.hpp"
+#include "seq_binary.hpp"
+#include "seq_file.hpp"
+#include "seq_thread.hpp"
+
+namespace seq_logger {
+    ///\brief Drain thread of a sink added with sink_mode::own_thread. Keeps at most max_pending_batches_ batches,
+    /// dropping the oldest one when the sink cannot keep up. Priority batches are written first and never dropped
+    class seq_sink_worker {
+    public:
+        seq_sink_worker(std::shared_ptr<seq_sink> sink_, size_t max_pending_batches_,
+                        seq_thread_options thread_options_ = {})
+                : _sink(std::move(sink_)), _max_pending_batches(max_pending_batches_),
+                  _thread_options(std::move(thread_options_)) {
+            _thread = std::thread(&seq_sink_worker::run, this);
+        }
+
+        ~seq_sink_worker() {
+            stop();
+        }
+
+        seq_sink_worker(seq_sink_worker const &) = delete;
+
+        seq_sink_worker &operator=(seq_sink_worker const &) = delete;
+
+        void push(seq_log_batch_ptr batch_) {
+            std::lock_guard<std::mutex> guard(_mutex);
+            if (_stopping) {
+                // E.g. dispatched after shutdown() stopped the drain threads
+                seq_metrics::instance().events_dropped(batch_->entries.size());
+                return;
+            }
+            if (_pending.size() >= _max_pending_batches) {
+                auto oldest = std::find_if(_pending.begin(), _pending.end(), [](const seq_log_batch_ptr &batch_) {
+                    return !batch_->priority;
+                });
+                if (oldest != _pending.end()) {
+                    seq_metrics::instance().events_dropped((*oldest)->entries.size());
+                    _pending.erase(oldest);
+                }
+            }
+            if (batch_->priority) {
+                // Behind the priority batches already pending, ahead of the others
+                auto position = std::find_if(_pending.begin(), _pending.end(), [](const seq_log_batch_ptr &pending_) {
+                    return !pending_->priority;
+                });
+                _pending.insert(position, std::move(batch_));
+            } else {
+                _pending.push_back(std::move(batch_));
+            }
+            _wake.notify_one();
+        }
+
+        ///\brief Wait until everything pushed so far has been written
+        ///\return false if the deadline passed first
+        bool wait_idle(std::chrono::steady_clock::time_point deadline_) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            return _idle.wait_until(lock, deadline_, [this] { return _pending.empty() && !_writing; });
+        }
+
+        ///\brief Events pushed but not written yet
+        [[nodiscard]] uint64_t pending_events() {
+            std::lock_guard<std::mutex> guard(_mutex);
+            uint64_t events = 0;
+            for (const auto &batch: _pending) events += batch->entries.size();
+            return events;
+        }
+
+        ///\brief Write what is still pending and join the thread
+        void stop() {
+            {
+                std::lock_guard<std::mutex> guard(_mutex);
+                _stopping = true;
+                _wake.notify_one();
+            }
+            if (_thread.joinable()) _thread.join();
+        }
+
+        ///\brief Write what is pending until deadline_, drop the rest and join the thread
+        ///\return Number of events dropped
+        uint64_t stop(std::chrono::steady_clock::time_point deadline_) {
+            uint64_t dropped = 0;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _idle.wait_until(lock, deadline_, [this] { return _pending.empty() && !_writing; });
+                for (const auto &batch: _pending) dropped += batch->entries.size();
+                _pending.clear();
+                _stopping = true;
+                _wake.notify_one();
+            }
+            if (dropped > 0) seq_metrics::instance().events_dropped(dropped);
+            if (_thread.joinable()) _thread.join();
+            return dropped;
+        }
+
+    private:
+        void run();
+
+        std::shared_ptr<seq_sink> _sink;
+        size_t _max_pending_batches;
+        seq_thread_options _thread_options;
+        std::mutex _mutex;
+        std::condition_variable _wake;
+        std::condition_variable _idle;
+        std::deque<seq_log_batch_ptr> _pending;
+        bool _stopping{false};
+        bool _writing{false};
+        std::thread _thread;
+    };
+
+    ///\brief Newline-delimited CLEF file (same lines as sent to Seq), see rolling_file_writer
+    class clef_file_sink : public seq_sink {
+    public:
+        ///\param path_ Path of the active file, e.g. /var/log/my_service.clef
+        ///\param max_file_bytes_ Size after which the file is rotated, 0 disables size based rotation
+        ///\param max_file_age_ Age after which the file is rotated, zero disables time based rotation
+        ///\param compress_rotated_ Gzip rotated files in the background
+        ///\param backend_ Write the buffer on the calling thread or queue it on io_uring, see rolling_file_writer
+        explicit clef_file_sink(std::string path_, size_t max_file_bytes_ = 128 * 1024 * 1024,
+                                std::chrono::seconds max_file_age_ = std::chrono::hours(24),
+                                bool compress_rotated_ = false, logging_level level_ = logging_level::verbose,
+                                file_write_backend backend_ = file_write_backend::blocking)
+                : seq_sink(level_), _writer(std::move(path_), max_file_bytes_, max_file_age_, compress_rotated_,
+                                            1024 * 1024, backend_) {}
+
+        void write(const seq_log_entry &entry_) override {
+            _line.clear();
+            entry_.append_raw_json_entry(_line);
+            _line += '\n';
+            seq_metrics::instance().bytes_serialized(_line.size());
+            _writer.write(_line);
+        }
+
+        void end_batch() override {
+            _writer.flush();
+        }
+
+    private:
+        rolling_file_writer _writer;
+        std::string _line;
+    };
+
+    ///\brief Compact binary segment files, see seq_binary.hpp; seq_binary_decoder turns them into CLEF
+    class binary_file_sink : public seq_sink {
+    public:
+        ///\param directory_ Existing directory to write segments to
+        ///\param prefix_ Segment file name prefix
+        ///\param max_segment_bytes_ Segment size after which a new segment file is started
+        explicit binary_file_sink(std::string directory_, std::string prefix_ = "seq",
+                                  size_t max_segment_bytes_ = 64 * 1024 * 1024,
+                                  logging_level level_ = logging_level::verbose)
+                : seq_sink(level_), _writer(std::move(directory_), std::move(prefix_), max_segment_bytes_) {}
+
+        void write(const seq_log_entry &entry_) override {
+            _writer.begin_event(
+                    static_cast<uint8_t>(entry_.level),
+                    std::chrono::duration_cast<binary_format::ticks>(entry_.timestamp.time_since_epoch()).count(),
+                    entry_.message(), entry_.logger_name, entry_.property_count());
+            for (size_t i = 0; i < entry_.property_count(); ++i) {
+                auto property = entry_.property(i);
+                _writer.add_property(property.key, property.value);
+            }
+            _writer.end_event();
+        }
+
+        void end_batch() override {
+            _writer.flush();
+        }
+
+    private:
+        binary_segment_writer _writer;
+    };
+
+    ///\brief Ships batches to the Seq raw ingestion endpoint of one or more Seq nodes, honoring MinimumLevelAccepted of
+    /// their responses. With endpoint_selection::round_robin, large batches are split into contiguous sequence ranges
+    /// that are posted to the healthy nodes in parallel, one sender thread per node. A node failing a request is taken
+    /// out of rotation (its part fails over to the other nodes) until it passes /health again, probed on a thread of
+    /// its own so that a dead node does not hold up dispatching. Events are serialized while they are uploaded
+    /// (chunked transfer coding), so a batch is never held in memory as CLEF, whatever its size
+    class seq_http_sink : public seq_sink {
+    public:
+        ///\param addresses_ Addresses of the Seq nodes, e.g. 127.0.0.1:5341
+        ///\param api_key_ Seq API key, empty if none
+        ///\param selection_ How batches are spread over the nodes
+        explicit seq_http_sink(const std::vector<std::string> &addresses_, std::string api_key_ = "",
+                               endpoint_selection selection_ = endpoint_selection::round_robin,
+                               logging_level level_ = logging_level::verbose)
+                : seq_sink(level_), _selection(selection_) {
+            for (const auto &address: addresses_) {
+                _endpoints.push_back(std::make_unique<endpoint>(address));
+            }
+            _headers.emplace_back("Content-type", "application/json");
+            if (!api_key_.empty()) _headers.emplace_back("X-Seq-ApiKey", std::move(api_key_));
+        }
+
+        ///\param address_ Address of the Seq server, e.g. 127.0.0.1:5341
+        ///\param api_key_ Seq API key, empty if none
+        explicit seq_http_sink(const std::string &address_, std::string api_key_ = "",
+                               logging_level level_ = logging_level::verbose)
+                : seq_http_sink(std::vector<std::string>{address_}, std::move(api_key_), endpoint_selection::round_robin,
+                                level_) {}
+
+        ~seq_http_sink() override {
+            {
+                std::lock_guard<std::mutex> guard(_probe_mutex);
+                _probe_stopping = true;
+                _probe_wake.notify_one();
+            }
+            if (_prober.joinable()) _prober.join();
+            for (auto &e: _endpoints) {
+                {
+                    std::lock_guard<std::mutex> guard(e->sender_mutex);
+                    e->sender_stopping = true;
+                    e->sender_wake.notify_all();
+                }
+                if (e->sender.joinable()) e->sender.join();
+            }
+        }
+
+        seq_http_sink(seq_http_sink const &) = delete;
+
+        seq_http_sink &operator=(seq_http_sink const &) = delete;
+
+        [[nodiscard]] logging_level effective_level() const override;
+
+        void begin_batch(size_t events_) override {
+            _entries.clear();
+            _entries.reserve(events_);
+        }
+
+        ///\brief Entries stay alive until the batch was written by all sinks, they are serialized in end_batch()
+        void write(const seq_log_entry &entry_) override {
+            _entries.push_back(&entry_);
+        }
+
+        void end_batch() override;
+
+        ///\brief Probe /health of every node, taking failing ones out of rotation
+        ///\return Whether at least one node is in service
+        bool check_health(std::chrono::milliseconds timeout_) {
+            bool any(false);
+            for (auto &e: _endpoints) {
+                any = probe(*e, timeout_) || any;
+            }
+            return any;
+        }
+
+        ///\brief Interval at which nodes taken out of rotation are probed again
+        std::chrono::milliseconds health_retry_interval{5000};
+
+        ///\brief Timeout of the /health probes of nodes taken out of rotation
+        std::chrono::milliseconds health_probe_timeout{1000};
+
+        ///\brief Size of the chunks batches are uploaded in, the memory a request needs besides the entries
+        size_t upload_chunk_bytes{64 * 1024};
+
+        ///\brief With endpoint_selection::round_robin, batches are split over the healthy nodes into parts of at least
+        /// this many events, 0 sends every batch to a single node
+        size_t split_min_events{512};
+
+    private:
+        enum class post_result {
+            delivered,
+            rejected,
+            failed
+        };
+
+        struct endpoint {
+            explicit endpoint(const std::string &address_)
+                    : address(address_), ingestion("http://" + address_ + "/api/events/raw?clef"),
+                      health("http://" + address_ + "/health") {}
+
+            std::string address;
+            ///\brief Only used by the thread writing the sink
+            http::Request ingestion;
+            ///\brief Guards health, probed by check_health() and by the probe thread
+            std::mutex health_mutex;
+            http::Request health;
+            std::atomic<bool> healthy{true};
+            ///\brief steady_clock time (ns since epoch) of the next /health probe while unhealthy
+            std::atomic<int64_t> retry_at_ns{0};
+            ///\brief Whether the probe thread is asked to probe the node
+            std::atomic<bool> probe_requested{false};
+            ///\brief Exponentially weighted moving average of successful request latency
+            std::atomic<int64_t> latency_us{0};
+            ///\brief Posts the part of a batch handed over by start_part(), started on first use
+            std::thread sender;
+            ///\brief Guards the part and the sender state, ingestion is only used by one thread at a time
+            std::mutex sender_mutex;
+            std::condition_variable sender_wake;
+            const seq_log_entry *const *part{nullptr};
+            size_t part_size{0};
+            bool part_pending{false};
+            post_result part_result{post_result::failed};
+            bool sender_stopping{false};
+        };
+
+        static int64_t steady_now_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        ///\brief Timeout for a request: none, unless a seq::flush() with a deadline is in progress
+        static std::chrono::milliseconds request_timeout();
+
+        bool probe(endpoint &endpoint_, std::chrono::milliseconds timeout_) {
+            bool in_service(false);
+            try {
+                std::lock_guard<std::mutex> guard(endpoint_.health_mutex);
+                const auto &response = endpoint_.health.sendInPlace("GET", {}, {}, timeout_);
+                in_service = response.code == 200 ||
+                             response.body.find("The Seq node is in service.") != std::string_view::npos;
+            } catch (const std::exception &) {}
+            mark(endpoint_, in_service);
+            return in_service;
+        }
+
+        void mark(endpoint &endpoint_, bool healthy_) {
+            endpoint_.healthy.store(healthy_, std::memory_order_relaxed);
+            if (!healthy_) {
+                endpoint_.retry_at_ns.store(steady_now_ns() + std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        health_retry_interval).count(), std::memory_order_relaxed);
+            }
+        }
+
+        ///\brief Nodes to post to, in order of preference. When no node is healthy all of them are tried anyway.
+        /// Nodes out of rotation whose retry time came are handed to the probe thread, and stay out until it is done
+        std::vector<endpoint *> candidates() {
+            auto now = steady_now_ns();
+            std::vector<endpoint *> result;
+            bool probe_due(false);
+            for (auto &e: _endpoints) {
+                if (e->healthy.load(std::memory_order_relaxed)) {
+                    result.push_back(e.get());
+                } else if (e->retry_at_ns.load(std::memory_order_relaxed) <= now &&
+                           !e->probe_requested.exchange(true, std::memory_order_relaxed)) {
+                    probe_due = true;
+                }
+            }
+            if (probe_due) request_probe();
+            if (result.empty()) {
+                for (auto &e: _endpoints) result.push_back(e.get());
+            }
+            if (_selection == endpoint_selection::least_latency) {
+                std::stable_sort(result.begin(), result.end(), [](const endpoint *l_, const endpoint *r_) {
+                    return l_->latency_us.load(std::memory_order_relaxed) < r_->latency_us.load(std::memory_order_relaxed);
+                });
+            } else if (!result.empty()) {
+                std::rotate(result.begin(), result.begin() + (_next++ % result.size()), result.end());
+            }
+            return result;
+        }
+
+        ///\brief Wake the probe thread, starting it on first use
+        void request_probe() {
+            std::lock_guard<std::mutex> guard(_probe_mutex);
+            if (_probe_stopping) return;
+            _probe_pending = true;
+            if (!_prober.joinable()) _prober = std::thread(&seq_http_sink::probe_loop, this);
+            _probe_wake.notify_one();
+        }
+
+        void probe_loop() {
+            in_logger_thread() = true;
+            set_current_thread_name("seq-probe");
+            std::unique_lock<std::mutex> lock(_probe_mutex);
+            for (;;) {
+                _probe_wake.wait(lock, [this] { return _probe_stopping || _probe_pending; });
+                if (_probe_stopping) return;
+                _probe_pending = false;
+                lock.unlock();
+                for (auto &e: _endpoints) {
+                    if (e->probe_requested.load(std::memory_order_relaxed)) {
+                        probe(*e, health_probe_timeout);
+                        e->probe_requested.store(false, std::memory_order_relaxed);
+                    }
+                }
+                lock.lock();
+            }
+        }
+
+        ///\brief Stream the CLEF of count_ entries to endpoint_
+        post_result post(endpoint &endpoint_, const seq_log_entry *const *entries_, size_t count_);
+
+        ///\brief Post the entries to the first of nodes_ taking them, taking the ones failing out of rotation
+        ///\return Whether the entries were delivered
+        bool deliver(const std::vector<endpoint *> &nodes_, const seq_log_entry *const *entries_, size_t count_);
+
+        ///\brief Hand a part of the batch to the sender thread of endpoint_, see wait_part()
+        void start_part(endpoint &endpoint_, const seq_log_entry *const *entries_, size_t count_);
+
+        post_result wait_part(endpoint &endpoint_);
+
+        void sender_loop(endpoint &endpoint_);
+
+        std::vector<std::unique_ptr<endpoint>> _endpoints;
+        http::HeaderFields _headers;
+        endpoint_selection _selection;
+        size_t _next{0};
+        std::vector<const seq_log_entry *> _entries;
+        std::mutex _probe_mutex;
+        std::condition_variable _probe_wake;
+        bool _probe_pending{false};
+        bool _probe_stopping{false};
+        std::thread _prober;
+    };
+
+
+    inline logging_level seq_http_sink::effective_level() const {
+        return std::max(level.load(std::memory_order_relaxed), seq::server_level_seq());
+    }
+
+    inline std::chrono::milliseconds seq_http_sink::request_timeout() {
+        auto deadline = seq::_s_flush_deadline_ns.load(std::memory_order_relaxed);
+        if (deadline == 0) return std::chrono::milliseconds(-1);
+        return std::chrono::milliseconds(std::max<int64_t>(0, (deadline - steady_now_ns()) / 1000000));
+    }
+
+    inline seq_http_sink::post_result seq_http_sink::post(endpoint &endpoint_, const seq_log_entry *const *entries_,
+                                                          size_t count_) {
+        auto &m = seq_metrics::instance();
+        auto request_start = std::chrono::steady_clock::now();
+        auto result = post_result::failed;
+        size_t bytes = 0;
+        try {
+            auto timeout = request_timeout();
+            if (timeout.count() == 0) return post_result::failed;
+            size_t next = 0;
+            auto next_chunk = [&](std::string &chunk_) {
+                auto start = chunk_.size();
+                while (next < count_ && chunk_.size() - start < upload_chunk_bytes) {
+                    entries_[next++]->append_raw_json_entry(chunk_);
+                    chunk_ += '\n';
+                }
+                bytes += chunk_.size() - start;
+                return next < count_;
+            };
+            const auto &resp = endpoint_.ingestion.sendChunkedInPlace("POST", next_chunk, _headers, timeout);
+            if (resp.code > 300) {
+                report_error(std::runtime_error("Seq at " + endpoint_.address + " refused a batch: " +
+                                                std::to_string(resp.code) + " " + std::string(resp.reason) + "\n" +
+                                                std::string(resp.body)));
+                // Client errors (bad payload, API key) would fail on any node as well
+                result = resp.code >= 500 ? post_result::failed : post_result::rejected;
+            } else {
+                result = post_result::delivered;
+                seq::update_server_level_seq(resp.body);
+            }
+        } catch (const std::exception &e) {
+            // Not logged: the event would be shipped through this very sink
+            report_error(std::runtime_error("Error while trying to ingest logs at " + endpoint_.address + ": " + e.what()));
+        }
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - request_start);
+        m.bytes_serialized(bytes);
+        m.request_sent(bytes, latency, result != post_result::delivered);
+        if (result == post_result::delivered) {
+            auto previous = endpoint_.latency_us.load(std::memory_order_relaxed);
+            endpoint_.latency_us.store(previous == 0 ? latency.count() : (previous * 7 + latency.count()) / 8,
+                                       std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    inline bool seq_http_sink::deliver(const std::vector<endpoint *> &nodes_, const seq_log_entry *const *entries_,
+                                       size_t count_) {
+        for (auto *e: nodes_) {
+            auto result = post(*e, entries_, count_);
+            if (result == post_result::delivered) return true;
+            if (result == post_result::rejected) return false;
+            // Running out of time during a flush says nothing about the node
+            if (request_timeout().count() == 0) return false;
+            mark(*e, false);
+        }
+        return false;
+    }
+
+    inline void seq_http_sink::start_part(endpoint &endpoint_, const seq_log_entry *const *entries_, size_t count_) {
+        std::lock_guard<std::mutex> guard(endpoint_.sender_mutex);
+        if (!endpoint_.sender.joinable()) {
+            endpoint_.sender = std::thread(&seq_http_sink::sender_loop, this, std::ref(endpoint_));
+        }
+        endpoint_.part = entries_;
+        endpoint_.part_size = count_;
+        endpoint_.part_pending = true;
+        endpoint_.sender_wake.notify_all();
+    }
+
+    inline seq_http_sink::post_result seq_http_sink::wait_part(endpoint &endpoint_) {
+        std::unique_lock<std::mutex> lock(endpoint_.sender_mutex);
+        endpoint_.sender_wake.wait(lock, [&] { return !endpoint_.part_pending; });
+        return endpoint_.part_result;
+    }
+
+    inline void seq_http_sink::sender_loop(endpoint &endpoint_) {
+        in_logger_thread() = true;
+        set_current_thread_name("seq-send");
+        std::unique_lock<std::mutex> lock(endpoint_.sender_mutex);
+        for (;;) {
+            endpoint_.sender_wake.wait(lock, [&] { return endpoint_.sender_stopping || endpoint_.part_pending; });
+            if (!endpoint_.part_pending) return;
+            lock.unlock();
+            auto result = post(endpoint_, endpoint_.part, endpoint_.part_size);
+            lock.lock();
+            endpoint_.part_result = result;
+            endpoint_.part_pending = false;
+            endpoint_.sender_wake.notify_all();
+        }
+    }
+
+    inline void seq_http_sink::end_batch() {
+        if (_entries.empty()) return;
+        auto nodes = candidates();
+        size_t parts = 1;
+        if (_selection == endpoint_selection::round_robin && split_min_events > 0) {
+            size_t healthy = 0;
+            for (auto *e: nodes) healthy += e->healthy.load(std::memory_order_relaxed) ? 1 : 0;
+            parts = std::max<size_t>(1, std::min(healthy, _entries.size() / split_min_events));
+        }
+        if (parts == 1) {
+            // The whole batch goes to one node, in order, failing over to the next candidates
+            if (!deliver(nodes, _entries.data(), _entries.size())) {
+                seq_metrics::instance().events_dropped(_entries.size());
+            }
+            return;
+        }
+
+        // Part i (a contiguous range of sequence numbers) goes to nodes[i], all in parallel; this thread posts part 0.
+        // Each node receives its events in order, a part failing over arrives after the parts delivered at once
+        auto part_begin = [&](size_t part_) { return _entries.size() * part_ / parts; };
+        for (size_t i = 1; i < parts; ++i) {
+            start_part(*nodes[i], _entries.data() + part_begin(i), part_begin(i + 1) - part_begin(i));
+        }
+        std::vector<post_result> results(parts);
+        results[0] = post(*nodes[0], _entries.data(), part_begin(1));
+        for (size_t i = 1; i < parts; ++i) results[i] = wait_part(*nodes[i]);
+
+        size_t dropped = 0;
+        for (size_t i = 0; i < parts; ++i) {
+            if (results[i] == post_result::delivered) continue;
+            auto *entries = _entries.data() + part_begin(i);
+            auto count = part_begin(i + 1) - part_begin(i);
+            if (results[i] == post_result::rejected || request_timeout().count() == 0) {
+                dropped += count;
+                continue;
+            }
+            mark(*nodes[i], false);
+            std::vector<endpoint *> others;
+            for (auto *e: nodes) {
+                if (e != nodes[i] && e->healthy.load(std::memory_order_relaxed)) others.push_back(e);
+            }
+            if (!deliver(others, entries, count)) dropped += count;
+        }
+        if (dropped > 0) seq_metrics::instance().events_dropped(dropped);
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+// Platform specific thread setup used by the dispatcher and the sink threads, see seq_thread_options in seq.hpp. Kept
+// out of seq.hpp so that with SEQ_LOGGER_COMPILED_LIB its system headers stay inside the library
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "seq.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <pthread.h>
+#  include <sched.h>
+#endif // defined(__unix__) || defined(__APPLE__)
+#if defined(__linux__)
+#  include <sys/resource.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif // defined(__linux__)
+
+namespace seq_logger {
+    ///\brief Name the calling thread, names are cut to the 15 characters Linux keeps
+    inline void set_current_thread_name(std::string name_) {
+        if (name_.size() > 15) name_.resize(15);
+#if defined(__APPLE__)
+        pthread_setname_np(name_.c_str());
+#elif defined(__linux__)
+        pthread_setname_np(pthread_self(), name_.c_str());
+#else
+        (void) name_;
+#endif // defined(__APPLE__)
+    }
+
+    ///\brief Apply options_ to the calling thread and name it options_.name_prefix + name_suffix_
+    ///\return Description of the settings that could not be applied (e.g. missing CAP_SYS_NICE), empty on success
+    inline std::string apply_thread_options(const seq_thread_options &options_, const std::string &name_suffix_) {
+        std::string errors;
+        auto fail = [&errors](const char *what_, int error_) {
+            if (!errors.empty()) errors += ", ";
+            errors += what_;
+            errors += ": ";
+            errors += std::strerror(error_);
+        };
+
+        set_current_thread_name(options_.name_prefix + name_suffix_);
+#if defined(__linux__)
+        if (!options_.cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu: options_.cpus) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+            }
+            if (sched_setaffinity(0, sizeof(set), &set) != 0) fail("CPU affinity", errno);
+        }
+#endif // defined(__linux__)
+#if defined(__unix__) || defined(__APPLE__)
+        if (options_.policy >= 0) {
+            sched_param param{};
+            param.sched_priority = options_.priority;
+            int error = pthread_setschedparam(pthread_self(), options_.policy, &param);
+            if (error != 0) fail("scheduling policy", error);
+        }
+#endif // defined(__unix__) || defined(__APPLE__)
+#if defined(__linux__)
+        // Linux keeps the nice value per thread
+        if (options_.set_nice &&
+            setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), options_.nice) != 0) {
+            fail("nice", errno);
+        }
+#endif // defined(__linux__)
+        return errors;
+    }
+}
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <system_error>
+
+#if defined(__linux__) && defined(__has_include)
+#  if __has_include(<linux/io_uring.h>)
+#    define SEQ_LOGGER_HAS_IO_URING 1
+#    include <linux/io_uring.h>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#  endif // __has_include(<linux/io_uring.h>)
+#endif // defined(__linux__) && defined(__has_include)
+
+namespace seq_logger {
+    ///\brief How rolling_file_writer writes its buffer out
+    enum class file_write_backend {
+        ///\brief write() on the flushing thread
+        blocking,
+        ///\brief Queued on io_uring_write_queue::shared() and submitted together with the writes of the other files at
+        /// the end of a dispatch. Falls back to blocking where io_uring is unavailable
+        io_uring
+    };
+
+    ///\brief Process wide io_uring (Linux 5.6+) for file writes, driven with plain syscalls. Writers queue writes,
+    /// submit() hands everything queued to the kernel with a single io_uring_enter, e.g. once all sinks of a dispatch
+    /// flushed; completions are collected when a writer waits for its write. Thread safe
+    class io_uring_write_queue {
+    public:
+        ///\brief Completion of a queued write, must stay alive until wait() returned
+        struct request {
+            bool done{true};
+            ///\brief Bytes written, or -errno
+            int result{0};
+        };
+
+        ///\brief Shared queue, created on first call
+        ///\return nullptr if io_uring is unavailable (old kernel, seccomp filter, kernel.io_uring_disabled)
+        static io_uring_write_queue *shared() {
+            static io_uring_write_queue *queue = [] {
+                // Never destroyed: files are closed (and their writes awaited) by static destructors
+                auto *created = new io_uring_write_queue(64);
+                if (!created->valid()) {
+                    delete created;
+                    created = nullptr;
+                }
+                instance().store(created, std::memory_order_release);
+                return created;
+            }();
+            return queue;
+        }
+
+        ///\brief shared() if some writer created it already, nullptr otherwise
+        static io_uring_write_queue *existing() {
+            return instance().load(std::memory_order_acquire);
+        }
+
+        io_uring_write_queue(io_uring_write_queue const &) = delete;
+
+        io_uring_write_queue &operator=(io_uring_write_queue const &) = delete;
+
+        ///\brief Queue a write of size_ bytes at the current position of fd_ (appending for O_APPEND files). data_
+        /// must stay valid until wait(request_) returned. Writes to the same file may complete in any order, so
+        /// writers keep a single write in flight
+        void write(int fd_, const char *data_, uint32_t size_, request &request_) {
+#if defined(SEQ_LOGGER_HAS_IO_URING)
+            std::lock_guard<std::mutex> guard(_mutex);
+            // Keep completions from overflowing the completion ring
+            while (_in_flight >= _cq_entries) throw_on_error(wait_locked());
+            auto tail = *_sq_tail;
+            if (tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) >= _sq_entries) {
+                throw_on_error(enter_locked(0));
+                tail = *_sq_tail;
+            }
+            auto index = tail & _sq_mask;
+            auto &sqe = _sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_WRITE;
+            sqe.fd = fd_;
+            sqe.addr = reinterpret_cast<uint64_t>(data_);
+            sqe.len = size_;
+            sqe.off = static_cast<uint64_t>(-1);
+            sqe.user_data = reinterpret_cast<uint64_t>(&request_);
+            _sq_array[index] = index;
+            request_.done = false;
+            __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+            ++_to_submit;
+            ++_in_flight;
+#else
+            (void) fd_;
+            (void) data_;
+            (void) size_;
+            (void) request_;
+#endif // defined(SEQ_LOGGER_HAS_IO_URING)
+        }
+
+        ///\brief Hand all queued writes to the kernel. Errors are left to wait() of the writers
+        void submit() noexcept {
+#if defined(SEQ_LOGGER_HAS_IO_URING)
+            std::lock_guard<std::mutex> guard(_mutex);
+            if (_to_submit > 0) enter_locked(0);
+#endif // defined(SEQ_LOGGER_HAS_IO_URING)
+        }
+
+        ///\brief Submit what is queued and wait until request_ completed
+        void wait(request &request_) {
+#if defined(SEQ_LOGGER_HAS_IO_URING)
+            std::lock_guard<std::mutex> guard(_mutex);
+            while (!request_.done) throw_on_error(wait_locked());
+#else
+            (void) request_;
+#endif // defined(SEQ_LOGGER_HAS_IO_URING)
+        }
+
+        ///\brief Submit what is queued and wait until all writes completed
+        ///\return false if io_uring_enter failed, errors are left to wait() of the writers
+        bool wait_all() noexcept {
+#if defined(SEQ_LOGGER_HAS_IO_URING)
+            std::lock_guard<std::mutex> guard(_mutex);
+            while (_in_flight > 0) {
+                if (wait_locked() != 0) return false;
+            }
+#endif // defined(SEQ_LOGGER_HAS_IO_URING)
+            return true;
+        }
+
+    private:
+        static std::atomic<io_uring_write_queue *> &instance() {
+            static std::atomic<io_uring_write_queue *> queue{nullptr};
+            return queue;
+        }
+
+#if defined(SEQ_LOGGER_HAS_IO_URING)
+        explicit io_uring_write_queue(unsigned entries_) {
+            io_uring_params params{};
+            _fd = static_cast<int>(syscall(__NR_io_uring_setup, entries_, &params));
+            if (_fd < 0) return;
+            // Writes at the current file position (offset -1) need 5.6, as IORING_OP_WRITE does
+            if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+                release();
+                return;
+            }
+            _sq_ring_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            _cq_ring_bytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (single_mmap) {
+                _sq_ring_bytes = _cq_ring_bytes = std::max(_sq_ring_bytes, _cq_ring_bytes);
+            }
+            _sq_ring = map(_sq_ring_bytes, IORING_OFF_SQ_RING);
+            _cq_ring = single_mmap ? _sq_ring : map(_cq_ring_bytes, IORING_OFF_CQ_RING);
+            _sqes_bytes = params.sq_entries * sizeof(io_uring_sqe);
+            auto *sqes = map(_sqes_bytes, IORING_OFF_SQES);
+            if (_sq_ring == nullptr || _cq_ring == nullptr || sqes == nullptr) {
+                if (sqes != nullptr) ::munmap(sqes, _sqes_bytes);
+                release();
+                return;
+            }
+            _sqes = static_cast<io_uring_sqe *>(sqes);
+            _sq_head = ring_field(_sq_ring, params.sq_off.head);
+            _sq_tail = ring_field(_sq_ring, params.sq_off.tail);
+            _sq_mask = *ring_field(_sq_ring, params.sq_off.ring_mask);
+            _sq_array = ring_field(_sq_ring, params.sq_off.array);
+            _sq_entries = params.sq_entries;
+            _cq_head = ring_field(_cq_ring, params.cq_off.head);
+            _cq_tail = ring_field(_cq_ring, params.cq_off.tail);
+            _cq_mask = *ring_field(_cq_ring, params.cq_off.ring_mask);
+            _cqes = reinterpret_cast<io_uring_cqe *>(static_cast<char *>(_cq_ring) + params.cq_off.cqes);
+            _cq_entries = params.cq_entries;
+        }
+
+        ~io_uring_write_queue() {
+            if (_sqes != nullptr) ::munmap(_sqes, _sqes_bytes);
+            release();
+        }
+
+        [[nodiscard]] bool valid() const {
+            return _fd >= 0;
+        }
+
+        void *map(size_t bytes_, off_t offset_) const {
+            void *memory = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, offset_);
+            return memory == MAP_FAILED ? nullptr : memory;
+        }
+
+        static unsigned *ring_field(void *ring_, uint32_t offset_) {
+            return reinterpret_cast<unsigned *>(static_cast<char *>(ring_) + offset_);
+        }
+
+        void release() {
+            if (_cq_ring != nullptr && _cq_ring != _sq_ring) ::munmap(_cq_ring, _cq_ring_bytes);
+            if (_sq_ring != nullptr) ::munmap(_sq_ring, _sq_ring_bytes);
+            _sq_ring = _cq_ring = nullptr;
+            if (_fd >= 0) ::close(_fd);
+            _fd = -1;
+        }
+
+        static void throw_on_error(int error_) {
+            if (error_ != 0) throw std::system_error{error_, std::system_category(), "io_uring_enter failed"};
+        }
+
+        ///\brief Submit what is queued, waiting for min_complete_ completions
+        ///\return errno, 0 on success
+        int enter_locked(unsigned min_complete_) {
+            for (;;) {
+                auto submitted = syscall(__NR_io_uring_enter, _fd, _to_submit, min_complete_,
+                                         min_complete_ > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+                if (submitted >= 0) {
+                    _to_submit -= static_cast<unsigned>(submitted);
+                    return 0;
+                }
+                if (errno != EINTR) return errno;
+            }
+        }
+
+        ///\brief Collect completions, blocking for at least one if there are none yet
+        ///\return errno, 0 on success
+        int wait_locked() {
+            if (reap_locked() > 0) return 0;
+            auto error = enter_locked(1);
+            reap_locked();
+            return error;
+        }
+
+        size_t reap_locked() {
+            auto head = *_cq_head;
+            auto tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+            size_t reaped = tail - head;
+            for (; head != tail; ++head) {
+                const auto &cqe = _cqes[head & _cq_mask];
+                auto *completed = reinterpret_cast<request *>(cqe.user_data);
+                completed->result = cqe.res;
+                completed->done = true;
+                --_in_flight;
+            }
+            __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+            return reaped;
+        }
+
+        std::mutex _mutex;
+        int _fd{-1};
+        void *_sq_ring{nullptr};
+        void *_cq_ring{nullptr};
+        size_t _sq_ring_bytes{0};
+        size_t _cq_ring_bytes{0};
+        size_t _sqes_bytes{0};
+        io_uring_sqe *_sqes{nullptr};
+        unsigned *_sq_head{nullptr};
+        unsigned *_sq_tail{nullptr};
+        unsigned *_sq_array{nullptr};
+        unsigned _sq_mask{0};
+        unsigned _sq_entries{0};
+        unsigned *_cq_head{nullptr};
+        unsigned *_cq_tail{nullptr};
+        io_uring_cqe *_cqes{nullptr};
+        unsigned _cq_mask{0};
+        unsigned _cq_entries{0};
+        unsigned _to_submit{0};
+        unsigned _in_flight{0};
+#else
+        explicit io_uring_write_queue(unsigned) {}
+
+        [[nodiscard]] bool valid() const {
+            return false;
+        }
+#endif // defined(SEQ_LOGGER_HAS_IO_URING)
+    };
+}
@@ -0,0 +1,157 @@
+// Binary segments: events written with binary_segment_writer decode to the same level, timestamp (100ns ticks),
+// strings and property values; version 1 segments (microseconds) are still read, a truncated trailing record ends
+// decoding and corrupted segments throw.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "seq_binary.hpp"
+#include "test_support.hpp"
+
+using namespace seq_logger;
+
+namespace {
+    struct decoded_event {
+        uint8_t level;
+        int64_t timestamp_ticks;
+        std::string message;
+        std::string logger;
+        std::vector<std::pair<std::string, std::string>> properties;
+    };
+
+    std::vector<decoded_event> decode(const std::string &data_) {
+        std::vector<decoded_event> events;
+        binary_segment_reader::read_buffer(data_, [&](const binary_event &event_) {
+            decoded_event event{event_.level, event_.timestamp_ticks, std::string(event_.message),
+                                std::string(event_.logger), {}};
+            for (const auto &property: event_.properties) {
+                event.properties.emplace_back(std::string(property.first), property.second);
+            }
+            events.push_back(std::move(event));
+        });
+        return events;
+    }
+
+    std::string read_file(const std::string &path_) {
+        std::string data;
+        std::FILE *file = std::fopen(path_.c_str(), "rb");
+        if (file == nullptr) return data;
+        char chunk[4096];
+        size_t read;
+        while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) data.append(chunk, read);
+        std::fclose(file);
+        return data;
+    }
+
+    void round_trip() {
+        // All 7 fractional digits set, and a timestamp before the epoch
+        auto now = std::chrono::duration_cast<binary_format::ticks>(std::chrono::system_clock::now().time_since_epoch());
+        const std::vector<decoded_event> events = {
+                {2, now.count() / 10000000 * 10000000 + 1234567, "Invoice {Id} created", "Billing.Invoices",
+                        {{"Id", "42"}, {"Customer", "M\xC3\xBCller \"GmbH\""}, {"Delta", "-17"}}},
+                {4, now.count() + 1, "Invoice {Id} created", "Billing.Invoices",
+                        {{"Id", "007"}, {"Empty", ""}, {"Large", "123456789012345678901"}, {"Minus", "-0"}}},
+                {0, -123456789, "Before the epoch", "Default", {}},
+        };
+
+        char directory[] = "/tmp/seq_binary_format_testXXXXXX";
+        if (!SEQ_CHECK(::mkdtemp(directory) != nullptr)) return;
+        std::string path;
+        {
+            binary_segment_writer writer(directory, "test", size_t{1} << 20);
+            for (const auto &event: events) {
+                writer.begin_event(event.level, event.timestamp_ticks, event.message, event.logger, event.properties.size());
+                for (const auto &property: event.properties) writer.add_property(property.first, property.second);
+                writer.end_event();
+            }
+            path = writer.segment_path();
+        }
+        auto data = read_file(path);
+        std::remove(path.c_str());
+        ::rmdir(directory);
+
+        SEQ_CHECK(data.size() > binary_format::header_size);
+        SEQ_CHECK(static_cast<uint8_t>(data[4]) == binary_format::version);
+        auto decoded = decode(data);
+        if (SEQ_CHECK(decoded.size() == events.size())) {
+            for (size_t i = 0; i < events.size(); ++i) {
+                SEQ_CHECK(decoded[i].level == events[i].level);
+                SEQ_CHECK(decoded[i].timestamp_ticks == events[i].timestamp_ticks);
+                SEQ_CHECK(decoded[i].message == events[i].message);
+                SEQ_CHECK(decoded[i].logger == events[i].logger);
+                // Values are stored as integers only if that gives back exactly the same text
+                SEQ_CHECK(decoded[i].properties == events[i].properties);
+            }
+        }
+
+        // A record cut short (e.g. the process died mid-write) ends decoding without an error
+        SEQ_CHECK(decode(data.substr(0, data.size() - 3)).size() == events.size() - 1);
+        SEQ_CHECK(decode(data.substr(0, binary_format::header_size)).empty());
+    }
+
+    ///\brief Header of a segment with the given format version
+    std::string segment_header(uint8_t version_) {
+        std::string data(binary_format::magic, sizeof(binary_format::magic));
+        data.push_back(static_cast<char>(version_));
+        data.append(3, '\0');
+        return data;
+    }
+
+    ///\brief Segment with a single event "m" at timestamp_, in the unit of version_
+    std::string single_event_segment(uint8_t version_, int64_t timestamp_) {
+        auto data = segment_header(version_);
+        data.push_back(static_cast<char>(binary_format::tag_string));
+        binary_format::put_varint(data, 0);
+        binary_format::put_varint(data, 1);
+        data.push_back('m');
+        data.push_back(static_cast<char>(binary_format::tag_event));
+        data.push_back(2);
+        binary_format::put_varint(data, binary_format::zigzag(timestamp_));
+        binary_format::put_varint(data, 1);
+        binary_format::put_varint(data, 1);
+        binary_format::put_varint(data, 0);
+        return data;
+    }
+
+    void versions() {
+        auto current = decode(single_event_segment(binary_format::version, 1234567));
+        SEQ_CHECK(current.size() == 1 && current[0].timestamp_ticks == 1234567 && current[0].message == "m");
+        // Version 1 stored microseconds
+        auto version1 = decode(single_event_segment(1, 1234567));
+        SEQ_CHECK(version1.size() == 1 && version1[0].timestamp_ticks == 12345670);
+        SEQ_CHECK_THROWS(decode(single_event_segment(binary_format::version + 1, 0)), std::runtime_error);
+    }
+
+    void corrupted() {
+        SEQ_CHECK_THROWS(decode("SEQ"), std::runtime_error);
+        SEQ_CHECK_THROWS(decode("SEQX" + segment_header(binary_format::version).substr(4)), std::runtime_error);
+
+        auto unknown_record = segment_header(binary_format::version);
+        unknown_record.push_back(0x7F);
+        SEQ_CHECK_THROWS(decode(unknown_record), std::runtime_error);
+
+        auto unknown_ref = single_event_segment(binary_format::version, 0);
+        unknown_ref[unknown_ref.size() - 2] = 5;
+        SEQ_CHECK_THROWS(decode(unknown_ref), std::runtime_error);
+
+        auto unexpected_id = segment_header(binary_format::version);
+        unexpected_id.push_back(static_cast<char>(binary_format::tag_string));
+        binary_format::put_varint(unexpected_id, 3);
+        binary_format::put_varint(unexpected_id, 0);
+        SEQ_CHECK_THROWS(decode(unexpected_id), std::runtime_error);
+    }
+}
+
+int main() {
+    round_trip();
+    versions();
+    corrupted();
+    return seq_logger_tests::test_result();
+}
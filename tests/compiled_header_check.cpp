@@ -0,0 +1,34 @@
+// Built against the seq_logger library (SEQ_LOGGER_COMPILED_LIB): seq.hpp must then only pull in the standard
+// library, the HTTP client, file outputs and platform headers stay inside src/seq.cpp. Fails to compile if one of
+// them leaks into the public header again.
+
+#include "seq.hpp"
+
+#ifndef SEQ_LOGGER_COMPILED_LIB
+#  error This check is meant to be built against the seq_logger library
+#endif // SEQ_LOGGER_COMPILED_LIB
+
+#if defined(HTTPREQUEST_HPP)
+#  error seq.hpp includes HTTPRequest.hpp
+#endif // defined(HTTPREQUEST_HPP)
+#if defined(_SYS_INOTIFY_H) || defined(_SYS_STAT_H) || defined(_UNISTD_H)
+#  error seq.hpp includes the config file watcher headers (seq_config.hpp)
+#endif // defined(_SYS_INOTIFY_H) || defined(_SYS_STAT_H) || defined(_UNISTD_H)
+#if defined(_SYS_RESOURCE_H) || defined(_SYSCALL_H)
+#  error seq.hpp includes the thread setup headers (seq_thread.hpp)
+#endif // defined(_SYS_RESOURCE_H) || defined(_SYSCALL_H)
+#if defined(_SYS_MMAN_H) || defined(LINUX_IO_URING_H)
+#  error seq.hpp includes the flight recorder or io_uring headers
+#endif // defined(_SYS_MMAN_H) || defined(LINUX_IO_URING_H)
+#if defined(_CPUID_H_INCLUDED) || defined(_X86INTRIN_H_INCLUDED)
+#  error seq.hpp includes the cpuid / x86intrin headers
+#endif // defined(_CPUID_H_INCLUDED) || defined(_X86INTRIN_H_INCLUDED)
+#if defined(_GLIBCXX_THREAD) || defined(_GLIBCXX_SHARED_MUTEX) || defined(_GLIBCXX_DEQUE) || \
+    defined(_GLIBCXX_SSTREAM) || defined(_GLIBCXX_IOSTREAM)
+#  error seq.hpp includes standard headers only the library needs
+#endif // defined(_GLIBCXX_THREAD) || ...
+
+int main() {
+    // Links against the library, without starting the dispatcher
+    return seq_logger::seq::stats().events_dropped == 0 ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+// Delivery to Seq over HTTP, against two mock_seq_server nodes started by the test (path given as the only argument):
+// a flush delivers every event exactly once, and a large batch is split between the nodes in round robin mode.
+//
+// Usage: seq_http_delivery_test path/to/mock_seq_server
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "HTTPRequest.hpp"
+#include "seq.hpp"
+#include "test_support.hpp"
+
+using namespace seq_logger;
+
+namespace {
+    ///\brief mock_seq_server child process, stopped when destroyed
+    class mock_server {
+    public:
+        mock_server(const char *executable_, int port_) : address("127.0.0.1:" + std::to_string(port_)) {
+            _pid = ::fork();
+            if (_pid == 0) {
+                auto port = std::to_string(port_);
+                ::execl(executable_, executable_, "--port", port.c_str(), "--report-interval-ms", "0",
+                        static_cast<char *>(nullptr));
+                std::perror("Failed to start mock_seq_server");
+                std::_Exit(127);
+            }
+        }
+
+        ~mock_server() {
+            if (_pid <= 0) return;
+            ::kill(_pid, SIGTERM);
+            ::waitpid(_pid, nullptr, 0);
+        }
+
+        mock_server(mock_server const &) = delete;
+
+        mock_server &operator=(mock_server const &) = delete;
+
+        ///\brief Wait until the server answers /health
+        bool wait_healthy() const {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (std::chrono::steady_clock::now() < deadline) {
+                try {
+                    http::Request request("http://" + address + "/health");
+                    if (request.send("GET", "", {}, std::chrono::milliseconds(500)).status.code == 200) return true;
+                } catch (const std::exception &) {}
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+            return false;
+        }
+
+        ///\brief Events received so far according to /stats, -1 if it cannot be queried
+        long long events_received() const {
+            try {
+                http::Request request("http://" + address + "/stats");
+                auto response = request.send("GET", "", {}, std::chrono::milliseconds(1000));
+                std::string json(response.body.begin(), response.body.end());
+                auto position = json.find("\"Events\":");
+                if (response.status.code != 200 || position == std::string::npos) return -1;
+                return std::strtoll(json.c_str() + position + 9, nullptr, 10);
+            } catch (const std::exception &) {
+                return -1;
+            }
+        }
+
+        const std::string address;
+
+    private:
+        pid_t _pid{-1};
+    };
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "Usage: %s path/to/mock_seq_server\n", argv[0]);
+        return 2;
+    }
+    // Ports depending on the process id, so parallel test runs do not collide
+    const int port = 20000 + static_cast<int>(::getpid() % 20000) * 2;
+    mock_server first(argv[1], port);
+    mock_server second(argv[1], port + 1);
+    if (!SEQ_CHECK(first.wait_healthy() && second.wait_healthy())) return seq_logger_tests::test_result();
+
+    // The interval is long enough that nothing is dispatched before the flush, so all events go out as one batch
+    seq::init(std::vector<std::string>{first.address, second.address}, logging_level::fatal, logging_level::verbose, 60000,
+              "", 2000, false, endpoint_selection::round_robin);
+    SEQ_CHECK(seq::wait_ready(std::chrono::milliseconds(5000)));
+
+    constexpr long long event_count = 3000;
+    seq log("DeliveryTest", logging_level::fatal, logging_level::verbose);
+    for (long long i = 0; i < event_count; ++i) {
+        log.info("Delivery test event {Index}", {{"Index", i}});
+    }
+    auto result = seq::flush(std::chrono::seconds(10));
+    SEQ_CHECK(result.delivered == event_count);
+    SEQ_CHECK(result.dropped == 0 && result.pending == 0);
+
+    auto first_received = first.events_received();
+    auto second_received = second.events_received();
+    SEQ_CHECK(first_received + second_received == event_count);
+    // The batch is large enough to be split into consecutive parts posted to both nodes in parallel
+    SEQ_CHECK(first_received > 0 && second_received > 0);
+
+    return seq_logger_tests::test_result();
+}
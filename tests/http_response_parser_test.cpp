@@ -0,0 +1,108 @@
+// http::ResponseParser, fed whole responses and byte by byte (as they may arrive from the socket): status line, header
+// fields, Content-Length, chunked and connection-delimited bodies, reuse after reset() and malformed responses.
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "HTTPRequest.hpp"
+#include "test_support.hpp"
+
+namespace {
+    ///\brief Feed response_ to parser_ in pieces of piece_size_ bytes
+    ///\return Whether the parser reported the response complete, and fed all of it by then
+    bool feed(http::ResponseParser &parser_, std::string_view response_, size_t piece_size_) {
+        for (size_t offset = 0; offset < response_.size(); offset += piece_size_) {
+            auto piece = response_.substr(offset, piece_size_);
+            auto room = parser_.prepare(piece.size());
+            std::memcpy(room.first, piece.data(), piece.size());
+            if (parser_.commit(piece.size())) return offset + piece.size() == response_.size();
+        }
+        return false;
+    }
+
+    std::string_view header(const http::ResponseView &response_, std::string_view name_) {
+        for (const auto &field: response_.headerFields) {
+            if (field.first == name_) return field.second;
+        }
+        return {};
+    }
+
+    void content_length() {
+        const std::string response = "HTTP/1.1 201 Created\r\nContent-Length: 5\r\nX-Seq-Node:  a  \r\n\r\nhello";
+        for (size_t piece_size: {response.size(), size_t{1}, size_t{3}, size_t{7}}) {
+            http::ResponseParser parser;
+            SEQ_CHECK(feed(parser, response, piece_size));
+            const auto &view = parser.view();
+            SEQ_CHECK(view.version.major == 1 && view.version.minor == 1);
+            SEQ_CHECK(view.code == 201);
+            SEQ_CHECK(view.reason == "Created");
+            SEQ_CHECK(view.body == "hello");
+            // Names are lower case, values trimmed
+            SEQ_CHECK(header(view, "x-seq-node") == "a");
+            SEQ_CHECK(header(view, "content-length") == "5");
+        }
+    }
+
+    void chunked() {
+        const std::string response = "HTTP/1.1 200 OK\r\nTransfer-Encoding: Chunked\r\nContent-Length: 99\r\n\r\n"
+                                     "5;name=value\r\nhello\r\n6\r\n world\r\n0\r\nX-Trailer: 1\r\n\r\n";
+        for (size_t piece_size: {response.size(), size_t{1}, size_t{4}}) {
+            http::ResponseParser parser;
+            SEQ_CHECK(feed(parser, response, piece_size));
+            // Content-Length is ignored with Transfer-Encoding
+            SEQ_CHECK(parser.view().body == "hello world");
+        }
+    }
+
+    void without_body() {
+        http::ResponseParser parser;
+        SEQ_CHECK(feed(parser, "HTTP/1.1 204 No Content\r\nContent-Length: 10\r\n\r\n", 1));
+        SEQ_CHECK(parser.view().code == 204);
+        SEQ_CHECK(parser.view().body.empty());
+    }
+
+    void delimited_by_close() {
+        http::ResponseParser parser;
+        SEQ_CHECK(!feed(parser, "HTTP/1.0 200 OK\r\n\r\nuntil the end", 2));
+        SEQ_CHECK(parser.finish());
+        SEQ_CHECK(parser.view().body == "until the end");
+
+        // A Content-Length body cut short by the server closing the connection is incomplete
+        http::ResponseParser cut;
+        SEQ_CHECK(!feed(cut, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nshort", 5));
+        SEQ_CHECK(!cut.finish());
+    }
+
+    void reset() {
+        http::ResponseParser parser;
+        SEQ_CHECK(feed(parser, "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 4\r\n\r\nbusy", 1));
+        SEQ_CHECK(parser.view().code == 503);
+        parser.reset();
+        SEQ_CHECK(feed(parser, "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok", 64));
+        SEQ_CHECK(parser.view().code == 200);
+        SEQ_CHECK(parser.view().reason == "OK");
+        SEQ_CHECK(parser.view().body == "ok");
+        SEQ_CHECK(header(parser.view(), "content-length") == "2");
+    }
+
+    void malformed() {
+        for (const char *response: {"HTTX/1.1 200 OK\r\n\r\n", "HTTP/1.1 20 OK\r\n\r\n", "HTTP/1.1 200 OK\r\n: value\r\n\r\n",
+                                    "HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip\r\n\r\n",
+                                    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n",
+                                    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nabXX"}) {
+            http::ResponseParser parser;
+            SEQ_CHECK_THROWS(feed(parser, response, std::strlen(response)), http::ResponseError);
+        }
+    }
+}
+
+int main() {
+    content_length();
+    chunked();
+    without_body();
+    delimited_by_close();
+    reset();
+    malformed();
+    return seq_logger_tests::test_result();
+}
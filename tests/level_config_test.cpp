@@ -0,0 +1,88 @@
+// Level configuration: glob_match patterns, parse_level_rules, and config rules applied to registered loggers (last
+// match wins, levels restored once no rule matches), including loggers created after the rules were set.
+
+#include <string>
+
+#include "seq.hpp"
+#include "seq_config.hpp"
+#include "test_support.hpp"
+
+using namespace seq_logger;
+
+namespace {
+    void glob() {
+        SEQ_CHECK(glob_match("", ""));
+        SEQ_CHECK(!glob_match("", "Billing"));
+        SEQ_CHECK(glob_match("*", ""));
+        SEQ_CHECK(glob_match("*", "Billing.Invoices"));
+        SEQ_CHECK(glob_match("Billing", "Billing"));
+        SEQ_CHECK(!glob_match("Billing", "Billing.Invoices"));
+        SEQ_CHECK(!glob_match("Billing", "Billin"));
+        // '*' spans dots
+        SEQ_CHECK(glob_match("Billing.*", "Billing.Invoices.Pdf"));
+        SEQ_CHECK(!glob_match("Billing.*", "Billing"));
+        SEQ_CHECK(glob_match("*.Http", "Billing.Http"));
+        SEQ_CHECK(glob_match("*.Http", "Billing.Api.Http"));
+        SEQ_CHECK(!glob_match("*.Http", "Billing.Https"));
+        SEQ_CHECK(glob_match("*Http*", "Billing.Https.Client"));
+        SEQ_CHECK(glob_match("Bill?ng", "Billing"));
+        SEQ_CHECK(!glob_match("Bill?ng", "Billng"));
+        SEQ_CHECK(glob_match("?*?", "ab"));
+        SEQ_CHECK(!glob_match("?*?", "a"));
+        // Backtracking over an earlier partial match
+        SEQ_CHECK(glob_match("*a*b", "aaab.ab"));
+        SEQ_CHECK(!glob_match("*a*b", "aaab.a"));
+        SEQ_CHECK(glob_match("a**b", "ab"));
+    }
+
+    void parse_rules() {
+        auto rules = parse_level_rules("Billing.* = debug\n"
+                                       "  *.Http=warning ,  info  # console warnings only\n"
+                                       "# comment line\n"
+                                       "\n"
+                                       "Broken\n"
+                                       "Unknown.* = loud; Db = error", "level_config_test");
+        if (!SEQ_CHECK(rules.size() == 3)) return;
+        SEQ_CHECK(rules[0].pattern == "Billing.*");
+        SEQ_CHECK(rules[0].console == logging_level::debug && rules[0].seq == logging_level::debug);
+        SEQ_CHECK(rules[1].pattern == "*.Http");
+        SEQ_CHECK(rules[1].console == logging_level::warning && rules[1].seq == logging_level::info);
+        SEQ_CHECK(rules[2].pattern == "Db");
+        SEQ_CHECK(rules[2].console == logging_level::error && rules[2].seq == logging_level::error);
+    }
+
+    void apply_rules() {
+        auto invoices = seq::get("Billing.Invoices");
+        auto http = seq::get("Billing.Http");
+        invoices->level_console = logging_level::info;
+        invoices->level_seq = logging_level::warning;
+
+        seq::set_level_config("Billing.* = debug\n*.Http = error, fatal");
+        SEQ_CHECK(invoices->level_console == logging_level::debug && invoices->level_seq == logging_level::debug);
+        // The last matching rule wins
+        SEQ_CHECK(http->level_console == logging_level::error && http->level_seq == logging_level::fatal);
+        // Loggers created later get the rules as well
+        auto payments = seq::get("Billing.Payments");
+        SEQ_CHECK(payments->level_console == logging_level::debug && payments->level_seq == logging_level::debug);
+        seq local("Shop.Http", logging_level::verbose, logging_level::verbose);
+        SEQ_CHECK(local.level_console == logging_level::error && local.level_seq == logging_level::fatal);
+
+        // Loggers no longer matched get their own levels back
+        seq::set_level_config("*.Http = warning");
+        SEQ_CHECK(invoices->level_console == logging_level::info && invoices->level_seq == logging_level::warning);
+        SEQ_CHECK(http->level_console == logging_level::warning && local.level_seq == logging_level::warning);
+        seq::set_level_config("");
+        SEQ_CHECK(local.level_console == logging_level::verbose && local.level_seq == logging_level::verbose);
+
+        SEQ_CHECK(seq::release("Billing.Invoices"));
+        SEQ_CHECK(!seq::release("Billing.Invoices"));
+        SEQ_CHECK(seq::get("Billing.Invoices") != invoices);
+    }
+}
+
+int main() {
+    glob();
+    parse_rules();
+    apply_rules();
+    return seq_logger_tests::test_result();
+}
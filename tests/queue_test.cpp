@@ -0,0 +1,147 @@
+// Event queues without a dispatcher: merge_by_sequence restores the global logging order across loggers, and the
+// memory budget keeps the newest (drop_oldest) or oldest (drop_newest) events queued by several loggers, while the
+// priority lane is never dropped.
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "seq.hpp"
+#include "test_support.hpp"
+
+namespace seq_logger {
+    struct test_access {
+        static std::vector<seq_log_entry *> merge_by_sequence(std::vector<std::vector<seq_log_entry *>> &queues_) {
+            return seq::merge_by_sequence(queues_);
+        }
+
+        ///\brief Events queued by logger_, in queue order
+        static std::vector<const seq_log_entry *> queued(const seq &logger_, bool priority_ = false) {
+            std::lock_guard<std::mutex> guard(logger_._logs_mutex);
+            const auto &queue = priority_ ? logger_._seq_priority_queue : logger_._seq_dispatch_queue;
+            return {queue.begin(), queue.end()};
+        }
+
+        ///\brief Delete the queued events of logger_ and give their bytes back to the memory budget
+        static void drain(const seq &logger_) {
+            std::lock_guard<std::mutex> guard(logger_._logs_mutex);
+            for (auto *queue: {&logger_._seq_dispatch_queue, &logger_._seq_priority_queue}) {
+                for (auto *entry: *queue) {
+                    seq_memory_budget::instance().release(entry->budget_bytes);
+                    delete entry;
+                }
+                queue->clear();
+            }
+        }
+    };
+}
+
+using namespace seq_logger;
+
+namespace {
+    std::string event_number(const seq_log_entry &entry_) {
+        return entry_.property_count() > 0 ? std::string(entry_.property(0).value) : std::string();
+    }
+
+    ///\brief Numbers of the events queued by all of loggers_, in sequence order
+    std::vector<int> queued_numbers(const std::vector<const seq *> &loggers_) {
+        std::vector<const seq_log_entry *> entries;
+        for (const auto *logger: loggers_) {
+            auto queued = test_access::queued(*logger);
+            SEQ_CHECK(std::is_sorted(queued.begin(), queued.end(), [](const seq_log_entry *l_, const seq_log_entry *r_) {
+                return l_->sequence < r_->sequence;
+            }));
+            entries.insert(entries.end(), queued.begin(), queued.end());
+        }
+        std::sort(entries.begin(), entries.end(), [](const seq_log_entry *l_, const seq_log_entry *r_) {
+            return l_->sequence < r_->sequence;
+        });
+        std::vector<int> numbers;
+        for (const auto *entry: entries) numbers.push_back(std::stoi(event_number(*entry)));
+        return numbers;
+    }
+
+    void log_numbered(const std::vector<const seq *> &loggers_, int from_, int to_) {
+        for (int i = from_; i < to_; ++i) {
+            char number[8];
+            std::snprintf(number, sizeof(number), "%03d", i);
+            loggers_[static_cast<size_t>(i) % loggers_.size()]->info("Event {N}", {{"N", number}});
+        }
+    }
+
+    void merge_by_sequence() {
+        // Sequence numbers spread over queues the way loggers stamp them: increasing within each queue
+        std::vector<std::unique_ptr<seq_log_entry>> entries;
+        std::vector<std::vector<seq_log_entry *>> queues(4);
+        const size_t pattern[] = {2, 0, 0, 3, 1, 2, 2, 2, 0, 1, 3, 3, 0, 1, 2, 0};
+        for (uint64_t i = 0; i < 64; ++i) {
+            entries.emplace_back(seq_log_entry::create("Merge", seq_context(logging_level::info, {}, "Merge")));
+            entries.back()->sequence = 1000 + i * 3;
+            queues[pattern[i % 16] ^ (i / 16 % 4)].push_back(entries.back().get());
+        }
+        auto merged = test_access::merge_by_sequence(queues);
+        SEQ_CHECK(merged.size() == entries.size());
+        for (size_t i = 0; i < merged.size() && i < entries.size(); ++i) {
+            SEQ_CHECK(merged[i] == entries[i].get());
+        }
+
+        std::vector<std::vector<seq_log_entry *>> single{{entries[0].get(), entries[1].get()}};
+        auto single_merged = test_access::merge_by_sequence(single);
+        SEQ_CHECK(single_merged.size() == 2 && single_merged[0] == entries[0].get());
+
+        std::vector<std::vector<seq_log_entry *>> none;
+        SEQ_CHECK(test_access::merge_by_sequence(none).empty());
+    }
+
+    void memory_budget() {
+        seq first("Budget.A", logging_level::fatal, logging_level::verbose);
+        seq second("Budget.B", logging_level::fatal, logging_level::verbose);
+        const std::vector<const seq *> loggers{&first, &second};
+
+        // All events have the same size: the same message, a 3 digit number and logger names of the same length
+        log_numbered(loggers, 0, 1);
+        auto event_bytes = test_access::queued(first).front()->allocation_bytes();
+        test_access::drain(first);
+        const size_t budget_events = 10;
+
+        auto over_budget_before = seq::stats().events_over_budget;
+        seq::set_memory_budget(budget_events * event_bytes, drop_policy::drop_oldest);
+        log_numbered(loggers, 0, 100);
+        auto numbers = queued_numbers(loggers);
+        SEQ_CHECK(!numbers.empty() && numbers.size() <= budget_events);
+        // The newest events are kept, without gaps
+        for (size_t i = 0; i < numbers.size(); ++i) {
+            SEQ_CHECK(numbers[i] == static_cast<int>(100 - numbers.size() + i));
+        }
+        SEQ_CHECK(seq::stats().events_over_budget - over_budget_before == 100 - numbers.size());
+        SEQ_CHECK(seq_memory_budget::instance().used_bytes() == numbers.size() * event_bytes);
+
+        // Priority events bypass the budget
+        first.error("Priority {N}", {{"N", "999"}});
+        SEQ_CHECK(test_access::queued(first, true).size() == 1);
+        SEQ_CHECK(queued_numbers(loggers) == numbers);
+        SEQ_CHECK(seq_memory_budget::instance().used_bytes() == numbers.size() * event_bytes);
+
+        test_access::drain(first);
+        test_access::drain(second);
+        SEQ_CHECK(seq_memory_budget::instance().used_bytes() == 0);
+
+        seq::set_memory_budget(budget_events * event_bytes, drop_policy::drop_newest);
+        log_numbered(loggers, 0, 20);
+        numbers = queued_numbers(loggers);
+        SEQ_CHECK(numbers.size() == budget_events);
+        for (size_t i = 0; i < numbers.size(); ++i) SEQ_CHECK(numbers[i] == static_cast<int>(i));
+
+        test_access::drain(first);
+        test_access::drain(second);
+        seq::set_memory_budget(0);
+    }
+}
+
+int main() {
+    merge_by_sequence();
+    memory_budget();
+    return seq_logger_tests::test_result();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+// Checks for the test programs run by ctest: failed checks are reported with their location and make the program
+// exit non-zero through test_result(), the remaining checks still run.
+
+#include <cstdio>
+
+namespace seq_logger_tests {
+    inline int &failed_checks() {
+        static int failed = 0;
+        return failed;
+    }
+
+    inline bool check(bool passed_, const char *expression_, const char *file_, int line_) {
+        if (!passed_) {
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", file_, line_, expression_);
+            ++failed_checks();
+        }
+        return passed_;
+    }
+
+    ///\brief Exit code of the test program
+    inline int test_result() {
+        if (failed_checks() > 0) std::fprintf(stderr, "%d check(s) failed\n", failed_checks());
+        return failed_checks() == 0 ? 0 : 1;
+    }
+}
+
+#define SEQ_CHECK(condition_) seq_logger_tests::check(static_cast<bool>(condition_), #condition_, __FILE__, __LINE__)
+
+#define SEQ_CHECK_THROWS(expression_, exception_)                                                                    \
+    do {                                                                                                             \
+        bool thrown_(false);                                                                                         \
+        try {                                                                                                        \
+            (void) (expression_);                                                                                    \
+        } catch (const exception_ &) {                                                                               \
+            thrown_ = true;                                                                                          \
+        }                                                                                                            \
+        seq_logger_tests::check(thrown_, #expression_ " throws " #exception_, __FILE__, __LINE__);                    \
+    } while (false)
@@ -0,0 +1,257 @@
+// Minimal Seq stand-in for throughput testing of the logger without a real Seq instance.
+// Implements GET /health, POST /api/events/raw?clef (Content-Length or chunked bodies) and GET /stats.
+//
+// Usage: mock_seq_server [--port 5341] [--latency-ms 0] [--error-rate 0.0] [--minimum-level Warning]
+//                        [--report-interval-ms 1000]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    struct options {
+        int port = 5341;
+        int latency_ms = 0;
+        double error_rate = 0.0;
+        std::string minimum_level;
+        int report_interval_ms = 1000;
+    };
+
+    struct server_stats {
+        std::atomic<uint64_t> batches{0};
+        std::atomic<uint64_t> events{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> rejected_batches{0};
+        std::mutex latencies_mutex;
+        std::vector<int64_t> latencies_us;
+    };
+
+    options opts;
+    server_stats stats;
+
+    int64_t steady_now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool send_all(int fd_, const std::string &data_) {
+        size_t sent = 0;
+        while (sent < data_.size()) {
+            auto result = ::send(fd_, data_.data() + sent, data_.size() - sent, MSG_NOSIGNAL);
+            if (result <= 0) return false;
+            sent += static_cast<size_t>(result);
+        }
+        return true;
+    }
+
+    void respond(int fd_, int code_, const char *reason_, const std::string &body_) {
+        std::string response = "HTTP/1.1 " + std::to_string(code_) + " " + reason_ + "\r\n"
+                               "Content-Type: application/json\r\n"
+                               "Content-Length: " + std::to_string(body_.size()) + "\r\n"
+                               "Connection: close\r\n\r\n" + body_;
+        send_all(fd_, response);
+    }
+
+    /// Reads from the socket until `buffer_` holds at least `size_` bytes
+    bool fill(int fd_, std::string &buffer_, size_t size_) {
+        char chunk[65536];
+        while (buffer_.size() < size_) {
+            auto result = ::recv(fd_, chunk, sizeof(chunk), 0);
+            if (result <= 0) return false;
+            buffer_.append(chunk, static_cast<size_t>(result));
+        }
+        return true;
+    }
+
+    bool read_line(int fd_, std::string &buffer_, size_t from_, size_t &line_end_) {
+        for (;;) {
+            line_end_ = buffer_.find("\r\n", from_);
+            if (line_end_ != std::string::npos) return true;
+            if (!fill(fd_, buffer_, buffer_.size() + 1)) return false;
+        }
+    }
+
+    /// Reads the whole request, returns false if the connection dropped or the request is malformed
+    bool read_request(int fd_, std::string &request_line_, std::string &body_) {
+        std::string buffer;
+        size_t header_end;
+        for (;;) {
+            header_end = buffer.find("\r\n\r\n");
+            if (header_end != std::string::npos) break;
+            if (!fill(fd_, buffer, buffer.size() + 1)) return false;
+        }
+        request_line_ = buffer.substr(0, buffer.find("\r\n"));
+
+        std::string headers = buffer.substr(0, header_end + 2);
+        std::transform(headers.begin(), headers.end(), headers.begin(), [](unsigned char c) { return std::tolower(c); });
+        size_t position = header_end + 4;
+
+        if (headers.find("transfer-encoding: chunked") != std::string::npos) {
+            for (;;) {
+                size_t line_end;
+                if (!read_line(fd_, buffer, position, line_end)) return false;
+                auto chunk_size = std::strtoull(buffer.c_str() + position, nullptr, 16);
+                position = line_end + 2;
+                if (chunk_size == 0) return true;
+                if (!fill(fd_, buffer, position + chunk_size + 2)) return false;
+                body_.append(buffer, position, chunk_size);
+                position += chunk_size + 2;
+            }
+        }
+
+        auto content_length = headers.find("content-length:");
+        if (content_length == std::string::npos) return true;
+        auto length = std::strtoull(headers.c_str() + content_length + 15, nullptr, 10);
+        if (!fill(fd_, buffer, position + length)) return false;
+        body_ = buffer.substr(position, length);
+        return true;
+    }
+
+    void record_events(const std::string &body_) {
+        static const std::string sent_key = "\"LoadGenSentNs\":\"";
+        auto now = steady_now_ns();
+        uint64_t events = 0;
+        std::vector<int64_t> latencies;
+        size_t line_start = 0;
+        while (line_start < body_.size()) {
+            auto line_end = body_.find('\n', line_start);
+            if (line_end == std::string::npos) line_end = body_.size();
+            if (line_end > line_start) {
+                ++events;
+                auto key = body_.find(sent_key, line_start);
+                if (key != std::string::npos && key < line_end) {
+                    auto sent = std::strtoll(body_.c_str() + key + sent_key.size(), nullptr, 10);
+                    latencies.push_back((now - sent) / 1000);
+                }
+            }
+            line_start = line_end + 1;
+        }
+        stats.events += events;
+        stats.bytes += body_.size();
+        ++stats.batches;
+        if (!latencies.empty()) {
+            std::lock_guard<std::mutex> guard(stats.latencies_mutex);
+            stats.latencies_us.insert(stats.latencies_us.end(), latencies.begin(), latencies.end());
+        }
+    }
+
+    std::string stats_json() {
+        std::vector<int64_t> latencies;
+        {
+            std::lock_guard<std::mutex> guard(stats.latencies_mutex);
+            latencies = stats.latencies_us;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&](double p) {
+            return latencies.empty() ? int64_t{0} : latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+        };
+        return "{\"Batches\":" + std::to_string(stats.batches.load()) +
+               ",\"Events\":" + std::to_string(stats.events.load()) +
+               ",\"Bytes\":" + std::to_string(stats.bytes.load()) +
+               ",\"RejectedBatches\":" + std::to_string(stats.rejected_batches.load()) +
+               ",\"LatencyP50Us\":" + std::to_string(percentile(0.5)) +
+               ",\"LatencyP99Us\":" + std::to_string(percentile(0.99)) +
+               ",\"LatencyP999Us\":" + std::to_string(percentile(0.999)) +
+               ",\"LatencyMaxUs\":" + std::to_string(latencies.empty() ? 0 : latencies.back()) + "}";
+    }
+
+    void handle_connection(int fd_) {
+        thread_local std::mt19937 random(std::random_device{}());
+        std::string request_line, body;
+        if (read_request(fd_, request_line, body)) {
+            if (opts.latency_ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(opts.latency_ms));
+
+            if (request_line.rfind("GET /health", 0) == 0) {
+                respond(fd_, 200, "OK", R"({"status":"The Seq node is in service."})");
+            } else if (request_line.rfind("GET /stats", 0) == 0) {
+                respond(fd_, 200, "OK", stats_json());
+            } else if (request_line.rfind("POST /api/events/raw", 0) == 0) {
+                if (std::uniform_real_distribution<double>(0.0, 1.0)(random) < opts.error_rate) {
+                    ++stats.rejected_batches;
+                    respond(fd_, 503, "Service Unavailable", R"({"Error":"Injected failure"})");
+                } else {
+                    record_events(body);
+                    auto level = opts.minimum_level.empty() ? "null" : "\"" + opts.minimum_level + "\"";
+                    respond(fd_, 201, "Created", "{\"MinimumLevelAccepted\":" + level + "}");
+                }
+            } else {
+                respond(fd_, 404, "Not Found", "{}");
+            }
+        }
+        ::close(fd_);
+    }
+
+    void report_loop() {
+        uint64_t last_events = 0;
+        auto last = std::chrono::steady_clock::now();
+        for (;;) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(opts.report_interval_ms));
+            auto now = std::chrono::steady_clock::now();
+            auto events = stats.events.load();
+            auto seconds = std::chrono::duration<double>(now - last).count();
+            std::printf("%.0f events/s, %llu events, %llu batches, %llu rejected\n",
+                        static_cast<double>(events - last_events) / seconds,
+                        static_cast<unsigned long long>(events),
+                        static_cast<unsigned long long>(stats.batches.load()),
+                        static_cast<unsigned long long>(stats.rejected_batches.load()));
+            std::fflush(stdout);
+            last_events = events;
+            last = now;
+        }
+    }
+
+    void parse_options(int argc_, char **argv_) {
+        for (int i = 1; i + 1 < argc_; i += 2) {
+            std::string key = argv_[i];
+            std::string value = argv_[i + 1];
+            if (key == "--port") opts.port = std::atoi(value.c_str());
+            else if (key == "--latency-ms") opts.latency_ms = std::atoi(value.c_str());
+            else if (key == "--error-rate") opts.error_rate = std::atof(value.c_str());
+            else if (key == "--minimum-level") opts.minimum_level = value;
+            else if (key == "--report-interval-ms") opts.report_interval_ms = std::atoi(value.c_str());
+            else {
+                std::fprintf(stderr, "Unknown option %s\n", key.c_str());
+                std::exit(1);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    parse_options(argc, argv);
+
+    int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    int enable = 1;
+    ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(opts.port));
+    if (::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || ::listen(listener, 1024) != 0) {
+        std::perror("Failed to listen");
+        return 1;
+    }
+    std::printf("Mock Seq listening on port %d\n", opts.port);
+    std::fflush(stdout);
+
+    if (opts.report_interval_ms > 0) std::thread(report_loop).detach();
+    for (;;) {
+        int fd = ::accept(listener, nullptr, nullptr);
+        if (fd < 0) continue;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        std::thread(handle_connection, fd).detach();
+    }
+}
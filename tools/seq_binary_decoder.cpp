@@ -0,0 +1,75 @@
+// Turns binary segments written by seq::enable_binary_file_output into CLEF (newline delimited JSON), ready for
+// bulk import into Seq, e.g. with `seqcli ingest --json`.
+//
+// Usage: seq_binary_decoder [-o output.clef] segment.seqb [segment.seqb...]
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "seq.hpp"
+#include "seq_binary.hpp"
+
+namespace {
+    using namespace seq_logger;
+
+    ///\brief Same format as events sent to Seq: local time with 100ns precision and UTC offset
+    std::string format_timestamp(int64_t timestamp_ticks_) {
+        std::string result;
+        result.reserve(seq_clock::iso8601_length);
+        auto since_epoch = std::chrono::duration_cast<seq_clock::time_point::duration>(binary_format::ticks(timestamp_ticks_));
+        seq_clock::append_iso8601(result, seq_clock::time_point(since_epoch));
+        return result;
+    }
+
+    std::string to_clef(const binary_event &event_) {
+        std::string line = R"({"@t": ")" + format_timestamp(event_.timestamp_ticks) + R"(", "@mt":")" +
+                           helpers::escape_json(event_.message) + R"(", "@l":")" +
+                           logging_level_string(event_.level) +
+                           R"(","Logger":")" + helpers::escape_json(event_.logger) + "\"";
+        for (const auto &property: event_.properties) {
+            line += ",\"" + helpers::escape_json(property.first) + "\":\"" +
+                    helpers::escape_json(property.second) + "\"";
+        }
+        line += "}\n";
+        return line;
+    }
+}
+
+int main(int argc, char **argv) {
+    std::FILE *output = stdout;
+    std::vector<std::string> segments;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            output = std::fopen(argv[++i], "wb");
+            if (output == nullptr) {
+                std::perror("Failed to open output");
+                return 1;
+            }
+        } else {
+            segments.push_back(arg);
+        }
+    }
+    if (segments.empty()) {
+        std::fprintf(stderr, "Usage: %s [-o output.clef] segment.seqb [segment.seqb...]\n", argv[0]);
+        return 1;
+    }
+
+    size_t total = 0;
+    int result = 0;
+    for (const auto &segment: segments) {
+        try {
+            total += binary_segment_reader::read_file(segment, [&](const binary_event &event_) {
+                auto line = to_clef(event_);
+                std::fwrite(line.data(), 1, line.size(), output);
+            });
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "%s: %s\n", segment.c_str(), e.what());
+            result = 1;
+        }
+    }
+    std::fprintf(stderr, "Decoded %zu events from %zu segments\n", total, segments.size());
+    if (output != stdout) std::fclose(output);
+    return result;
+}
@@ -0,0 +1,68 @@
+// Extracts the last events from a flight recorder file (see seq::enable_flight_recorder), e.g. after a crash, as CLEF
+// (newline delimited JSON) ready for import into Seq, e.g. with `seqcli ingest --json`.
+//
+// Usage: seq_flight_recorder_dump [-n 1000] [-o output.clef] recorder.seqf
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "seq.hpp"
+#include "seq_flight_recorder.hpp"
+
+namespace {
+    using namespace seq_logger;
+
+    std::string to_clef(const flight_recorder_event &event_) {
+        std::string line = R"({"@t": ")";
+        seq_clock::append_iso8601(line, seq_clock::time_point(std::chrono::microseconds(event_.timestamp_us)));
+        line += R"(", "@mt":")" + helpers::escape_json(event_.message) + R"(", "@l":")" +
+                logging_level_string(event_.level) +
+                R"(","Logger":")" + helpers::escape_json(event_.logger) + "\"";
+        for (const auto &property: event_.properties) {
+            line += ",\"" + helpers::escape_json(property.first) + "\":\"" +
+                    helpers::escape_json(property.second) + "\"";
+        }
+        if (event_.truncated) line += R"(,"FlightRecorderTruncated":"true")";
+        line += "}\n";
+        return line;
+    }
+}
+
+int main(int argc, char **argv) {
+    std::FILE *output = stdout;
+    size_t last = 1000;
+    std::string path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            output = std::fopen(argv[++i], "wb");
+            if (output == nullptr) {
+                std::perror("Failed to open output");
+                return 1;
+            }
+        } else if (arg == "-n" && i + 1 < argc) {
+            last = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            path = arg;
+        }
+    }
+    if (path.empty()) {
+        std::fprintf(stderr, "Usage: %s [-n 1000] [-o output.clef] recorder.seqf\n", argv[0]);
+        return 1;
+    }
+
+    int result = 0;
+    try {
+        auto events = flight_recorder_reader::read_file(path, last, [&](const flight_recorder_event &event_) {
+            auto line = to_clef(event_);
+            std::fwrite(line.data(), 1, line.size(), output);
+        });
+        std::fprintf(stderr, "Extracted %zu events\n", events);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s: %s\n", path.c_str(), e.what());
+        result = 1;
+    }
+    if (output != stdout) std::fclose(output);
+    return result;
+}
@@ -0,0 +1,199 @@
+// Drives the logger at a target rate from many threads against a Seq (or mock_seq_server) instance and reports
+// sustained throughput, end-to-end delivery latency and loss. Latency and loss figures need the /stats endpoint of
+// mock_seq_server, against a real Seq only the client side numbers are reported.
+//
+// Usage: seq_load_generator [--address 127.0.0.1:5341[,127.0.0.1:5342...]] [--threads 4] [--rate 50000]
+//                           [--duration-s 10] [--dispatch-interval-ms 100] [--selection round-robin|least-latency]
+//                           [--memory-budget-mb 0]
+//
+// With several addresses, server side figures are summed over all nodes.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HTTPRequest.hpp"
+#include "seq.hpp"
+
+namespace {
+    struct options {
+        std::string address = "127.0.0.1:5341";
+        unsigned threads = 4;
+        uint64_t rate = 50000;
+        int duration_s = 10;
+        size_t dispatch_interval_ms = 100;
+        seq_logger::endpoint_selection selection = seq_logger::endpoint_selection::round_robin;
+        size_t memory_budget_mb = 0;
+    };
+
+    options opts;
+
+    void parse_options(int argc_, char **argv_) {
+        for (int i = 1; i + 1 < argc_; i += 2) {
+            std::string key = argv_[i];
+            std::string value = argv_[i + 1];
+            if (key == "--address") opts.address = value;
+            else if (key == "--threads") opts.threads = static_cast<unsigned>(std::atoi(value.c_str()));
+            else if (key == "--rate") opts.rate = std::strtoull(value.c_str(), nullptr, 10);
+            else if (key == "--duration-s") opts.duration_s = std::atoi(value.c_str());
+            else if (key == "--dispatch-interval-ms") opts.dispatch_interval_ms = std::strtoul(value.c_str(), nullptr, 10);
+            else if (key == "--selection") opts.selection = value == "least-latency" ? seq_logger::endpoint_selection::least_latency
+                                                                                     : seq_logger::endpoint_selection::round_robin;
+            else if (key == "--memory-budget-mb") opts.memory_budget_mb = std::strtoul(value.c_str(), nullptr, 10);
+            else {
+                std::fprintf(stderr, "Unknown option %s\n", key.c_str());
+                std::exit(1);
+            }
+        }
+    }
+
+    int64_t steady_now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::vector<std::string> addresses() {
+        std::vector<std::string> result;
+        size_t start = 0;
+        while (start <= opts.address.size()) {
+            auto end = opts.address.find(',', start);
+            if (end == std::string::npos) end = opts.address.size();
+            if (end > start) result.push_back(opts.address.substr(start, end - start));
+            start = end + 1;
+        }
+        return result;
+    }
+
+    /// Queries mock_seq_server /stats of every node (empty response for unreachable nodes), returns an empty list if
+    /// no node answers
+    std::vector<std::string> server_stats() {
+        std::vector<std::string> result;
+        bool any(false);
+        for (const auto &address: addresses()) {
+            result.emplace_back();
+            try {
+                http::Request request("http://" + address + "/stats");
+                auto response = request.send("GET", "", {}, std::chrono::milliseconds(1000));
+                if (response.status.code != 200) continue;
+                result.back().assign(response.body.begin(), response.body.end());
+                any = true;
+            } catch (const std::exception &) {}
+        }
+        if (!any) result.clear();
+        return result;
+    }
+
+    /// Sum of a counter over all nodes, or the maximum for latency figures
+    uint64_t stats_value(const std::vector<std::string> &nodes_, const std::string &key_) {
+        uint64_t result = 0;
+        for (const auto &json: nodes_) {
+            auto position = json.find("\"" + key_ + "\":");
+            if (position == std::string::npos) continue;
+            auto value = std::strtoull(json.c_str() + position + key_.size() + 3, nullptr, 10);
+            result = key_.rfind("Latency", 0) == 0 ? std::max<uint64_t>(result, value) : result + value;
+        }
+        return result;
+    }
+
+    void worker(unsigned index_, std::atomic<uint64_t> &sent_) {
+        using namespace seq_logger;
+        seq log(("LoadGenerator" + std::to_string(index_)).c_str(), logging_level::fatal, logging_level::verbose);
+        const uint64_t per_thread_rate = std::max<uint64_t>(opts.rate / opts.threads, 1);
+        const uint64_t burst = std::max<uint64_t>(per_thread_rate / 1000, 1);
+        const auto burst_interval = std::chrono::nanoseconds(1000000000ULL * burst / per_thread_rate);
+        const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(opts.duration_s);
+
+        auto next = std::chrono::steady_clock::now();
+        uint64_t sequence = 0;
+        while (std::chrono::steady_clock::now() < end) {
+            for (uint64_t i = 0; i < burst; ++i) {
+                log.info("Load generator event {Sequence} from {Worker}", {
+                        {"Sequence",      sequence++},
+                        {"Worker",        index_},
+                        {"LoadGenSentNs", steady_now_ns()}
+                });
+            }
+            sent_.fetch_add(burst, std::memory_order_relaxed);
+            next += burst_interval;
+            std::this_thread::sleep_until(next);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    using namespace seq_logger;
+    parse_options(argc, argv);
+    seq::set_memory_budget(opts.memory_budget_mb * 1024 * 1024);
+    seq::init(addresses(), logging_level::fatal, logging_level::verbose, opts.dispatch_interval_ms, "", 1000, true,
+              opts.selection);
+    if (!seq::wait_ready(std::chrono::milliseconds(2000))) {
+        std::fprintf(stderr, "Seq not ready, measuring anyway\n");
+    }
+
+    auto baseline = server_stats();
+    std::printf("Generating %llu events/s from %u threads for %ds against %s\n",
+                static_cast<unsigned long long>(opts.rate), opts.threads, opts.duration_s, opts.address.c_str());
+
+    std::atomic<uint64_t> sent{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < opts.threads; ++i) workers.emplace_back(worker, i, std::ref(sent));
+    for (auto &w: workers) w.join();
+    auto generation_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Give the dispatcher time to drain: wait until the server stops receiving, bounded by a few dispatch intervals
+    auto received = stats_value(server_stats(), "Events");
+    auto drain_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(opts.dispatch_interval_ms * 10 + 2000);
+    while (std::chrono::steady_clock::now() < drain_deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(opts.dispatch_interval_ms * 2 + 100));
+        auto now_received = stats_value(server_stats(), "Events");
+        if (now_received == received && seq::stats().queue_depth == 0) break;
+        received = now_received;
+    }
+    auto total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto client = seq::stats();
+    std::printf("Generated:           %llu events in %.2fs (%.0f events/s)\n",
+                static_cast<unsigned long long>(sent.load()), generation_seconds, static_cast<double>(sent.load()) / generation_seconds);
+    std::printf("Client:              %llu enqueued, %llu dropped, %llu over budget, %llu filtered, %llu still queued\n",
+                static_cast<unsigned long long>(client.total_enqueued()),
+                static_cast<unsigned long long>(client.events_dropped),
+                static_cast<unsigned long long>(client.events_over_budget),
+                static_cast<unsigned long long>(client.events_filtered),
+                static_cast<unsigned long long>(client.queue_depth));
+    std::printf("HTTP:                %llu requests, %llu failures, %llu bytes sent, latency p50 %lluus p99 %lluus\n",
+                static_cast<unsigned long long>(client.http_requests),
+                static_cast<unsigned long long>(client.http_failures),
+                static_cast<unsigned long long>(client.bytes_sent),
+                static_cast<unsigned long long>(client.http_latency.percentile(0.5)),
+                static_cast<unsigned long long>(client.http_latency.percentile(0.99)));
+
+    auto server = server_stats();
+    if (server.empty()) {
+        std::printf("Server:              /stats not available (not a mock_seq_server?)\n");
+        return 0;
+    }
+    auto delivered = stats_value(server, "Events") - stats_value(baseline, "Events");
+    auto lost = sent.load() > delivered ? sent.load() - delivered : 0;
+    std::printf("Delivered:           %llu events (%.0f events/s sustained), %llu lost (%.3f%%)\n",
+                static_cast<unsigned long long>(delivered), static_cast<double>(delivered) / total_seconds,
+                static_cast<unsigned long long>(lost),
+                sent.load() == 0 ? 0.0 : 100.0 * static_cast<double>(lost) / static_cast<double>(sent.load()));
+    if (server.size() > 1) {
+        for (size_t i = 0; i < server.size(); ++i) {
+            std::printf("  node %zu:            %llu events\n", i,
+                        static_cast<unsigned long long>(stats_value({server[i]}, "Events") -
+                                                            (i < baseline.size() ? stats_value({baseline[i]}, "Events") : 0)));
+        }
+    }
+    std::printf("Delivery latency:    p50 %lluus p99 %lluus p999 %lluus max %lluus\n",
+                static_cast<unsigned long long>(stats_value(server, "LatencyP50Us")),
+                static_cast<unsigned long long>(stats_value(server, "LatencyP99Us")),
+                static_cast<unsigned long long>(stats_value(server, "LatencyP999Us")),
+                static_cast<unsigned long long>(stats_value(server, "LatencyMaxUs")));
+    return 0;
+}